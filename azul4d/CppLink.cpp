@@ -16,108 +16,401 @@
 
 #include "CppLink.hpp"
 
-Mesh_d CppLink::refine(Polygon_d &polygon, double ratio, double size) {
-  Mesh_d polygon_refined;
-    
-  // Plane passing through points 0-2 is defined by the space of vector_01 and vector_02
-  CGAL::Point_d<Kernel> origin = polygon.vertices[0];
-  CGAL::Vector_d<Kernel> vector_01 = polygon.vertices[1]-origin;
-  vector_01 /= sqrt(vector_01.squared_length());
-  
-  CGAL::Hyperplane_d<Kernel> orthogonal_to_vector_01(origin, vector_01.direction());
-  double k = (orthogonal_to_vector_01.coefficient(0)*polygon.vertices[2][0]+orthogonal_to_vector_01.coefficient(1)*polygon.vertices[2][1]+orthogonal_to_vector_01.coefficient(2)*polygon.vertices[2][2]+orthogonal_to_vector_01.coefficient(3)*polygon.vertices[2][3]+orthogonal_to_vector_01.coefficient(4))/(orthogonal_to_vector_01.coefficient(0)*orthogonal_to_vector_01.coefficient(0)+orthogonal_to_vector_01.coefficient(1)*orthogonal_to_vector_01.coefficient(1)+orthogonal_to_vector_01.coefficient(2)*orthogonal_to_vector_01.coefficient(2)+orthogonal_to_vector_01.coefficient(3)*orthogonal_to_vector_01.coefficient(3));
-  double point_2_projected_to_plane_coordinates[4] = {polygon.vertices[2][0]-k*orthogonal_to_vector_01.coefficient(0),
-    polygon.vertices[2][1]-k*orthogonal_to_vector_01.coefficient(1),
-    polygon.vertices[2][2]-k*orthogonal_to_vector_01.coefficient(2),
-    polygon.vertices[2][3]-k*orthogonal_to_vector_01.coefficient(3)};
-  CGAL::Point_d<Kernel> point_2_projected_to_plane(4, point_2_projected_to_plane_coordinates, point_2_projected_to_plane_coordinates+4);
-  CGAL::Vector_d<Kernel> vector_02 = point_2_projected_to_plane-origin;
-  vector_02 /= sqrt(vector_02.squared_length());
+#include <algorithm>
+#include <future>
+#include <new>
+
+void GeometryBuffer::assign(const std::vector<Mesh_d> &meshes, const std::vector<std::uint32_t> &materialOfFace, const std::vector<Float4> &materials,
+                            const std::vector<Edge_d> &edges, const std::vector<Point4> &cornerPoints, double epsilon) {
+  
+  // Offsets first, so that every mesh and edge knows where its data goes
+  std::vector<std::size_t> meshVertexOffsets(meshes.size()+1, 0);
+  faceOffsets.resize(meshes.size()+1);
+  faceOffsets[0] = 0;
+  for (std::size_t face = 0; face < meshes.size(); ++face) {
+    meshVertexOffsets[face+1] = meshVertexOffsets[face]+meshes[face].vertices.size();
+    faceOffsets[face+1] = faceOffsets[face]+std::uint32_t(meshes[face].triangles.size());
+  } edgeOffsets.resize(edges.size()+1);
+  edgeOffsets[0] = 0;
+  for (std::size_t edge = 0; edge < edges.size(); ++edge) {
+    edgeOffsets[edge+1] = edgeOffsets[edge]+std::uint32_t(edges[edge].vertices.size());
+  }
   
-  // Project a polygon to the plane
-  Polygon_d polygon_2d;
-  for (auto point : polygon.vertices) {
-    CGAL::Vector_d<Kernel> point_vector = point-origin;
-    double coordinates_2d[2] = {point_vector*vector_01, point_vector*vector_02};
-    polygon_2d.vertices.push_back(CGAL::Point_d<Kernel>(2, coordinates_2d, coordinates_2d+2));
+  // Weld. Vertices are already unique within each mesh, so only the meshes'
+  // vertex lists go through the hash table and not every triangle corner.
+  PointIndex vertexIndex(meshVertexOffsets.back()+edgeOffsets.back()+cornerPoints.size(), epsilon);
+  std::vector<std::uint32_t> weldedMeshVertices(meshVertexOffsets.back());
+  for (std::size_t face = 0; face < meshes.size(); ++face) {
+    for (std::size_t vertex = 0; vertex < meshes[face].vertices.size(); ++vertex) {
+      weldedMeshVertices[meshVertexOffsets[face]+vertex] = vertexIndex.insert(meshes[face].vertices[vertex]);
+    }
+  } edgeVertices.resize(edgeOffsets.back());
+  for (std::size_t edge = 0; edge < edges.size(); ++edge) {
+    for (std::size_t vertex = 0; vertex < edges[edge].vertices.size(); ++vertex) {
+      edgeVertices[edgeOffsets[edge]+vertex] = vertexIndex.insert(edges[edge].vertices[vertex]);
+    }
+  } corners.resize(cornerPoints.size());
+  for (std::size_t corner = 0; corner < cornerPoints.size(); ++corner) {
+    corners[corner] = vertexIndex.insert(cornerPoints[corner]);
   }
   
+  vertices.resize(vertexIndex.size());
+  parallelFor(vertices.size(), [&](std::size_t vertex) {
+    vertices[vertex] = Float4(vertexIndex.points[vertex]);
+  });
+  
+  // Renumber the triangles of every mesh to the welded vertices
+  triangles.resize(faceOffsets.back());
+  parallelFor(meshes.size(), [&](std::size_t face) {
+    std::uint32_t *triangleVertex = &triangles[faceOffsets[face]];
+    for (auto const &meshVertex : meshes[face].triangles) *triangleVertex++ = weldedMeshVertices[meshVertexOffsets[face]+meshVertex];
+  });
+  
+  faceMaterials = materialOfFace;
+  materialColours = materials;
+}
+
+PlanarPolygon_d CppLink::toPlane(const Polygon_d &polygon) {
+  PlanarPolygon_d polygon_planar;
+  
+  // Plane through point 0 spanned by vector_01 and vector_02, which is the
+  // plane through points 0-2 unless they are repeated or collinear
+  polygon_planar.origin = polygon.vertices[0];
+  planeBasis(polygon.vertices.data(), polygon.vertices.size(), polygon_planar.vector_01, polygon_planar.vector_02);
+  
+  // Project a polygon to the plane
+  polygon_planar.shape.vertices.resize(polygon.vertices.size());
+  projectToPlane(polygon.vertices.data(), polygon.vertices.size(), polygon_planar.origin, polygon_planar.vector_01, polygon_planar.vector_02, polygon_planar.shape.vertices.data());
+  
+  return polygon_planar;
+}
+
+Mesh_d CppLink::refineShape(const Polygon_d &shape, double ratio, double size) {
+  Mesh_d shape_refined;
+  
   // Refine it
   CDT triangulation;
-  for (unsigned int index = 0; index < polygon_2d.vertices.size()-1; ++index) {
-    CDT::Vertex_handle current_vertex = triangulation.insert(CDT::Point(polygon_2d.vertices[index][0], polygon_2d.vertices[index][1]));
-    CDT::Vertex_handle next_vertex = triangulation.insert(CDT::Point(polygon_2d.vertices[index+1][0], polygon_2d.vertices[index+1][1]));
-    triangulation.insert_constraint(current_vertex, next_vertex);
-  } CDT::Vertex_handle last_vertex = triangulation.insert(CDT::Point(polygon_2d.vertices.back()[0], polygon_2d.vertices.back()[1]));
-  CDT::Vertex_handle first_vertex = triangulation.insert(CDT::Point(polygon_2d.vertices.front()[0], polygon_2d.vertices.front()[1]));
-  triangulation.insert_constraint(last_vertex, first_vertex);
+  std::vector<CDT::Vertex_handle> vertex_handles;
+  vertex_handles.reserve(shape.vertices.size());
+  for (auto const &point : shape.vertices) vertex_handles.push_back(triangulation.insert(CDT::Point(point[0], point[1])));
+  shape.forEachEdge([&](std::size_t current, std::size_t next) {
+    if (vertex_handles[current] != vertex_handles[next]) triangulation.insert_constraint(vertex_handles[current], vertex_handles[next]);
+  });
   //    std::cout << "Before: " << triangulation.number_of_vertices();
   CGAL::refine_Delaunay_mesh_2(triangulation, CGAL::Delaunay_mesh_size_criteria_2<CDT>(ratio, size));
   //    std::cout << " After: " << triangulation.number_of_vertices() << std::endl;
   
-  // Project the refined mesh back
-  for (auto current_face = triangulation.finite_faces_begin(); current_face != triangulation.finite_faces_end(); ++current_face) {
-    polygon_refined.triangles.push_back(Triangle_d());
-    polygon_refined.triangles.back().vertices[0] = origin+current_face->vertex(0)->point()[0]*vector_01+current_face->vertex(0)->point()[1]*vector_02;
-    polygon_refined.triangles.back().vertices[1] = origin+current_face->vertex(1)->point()[0]*vector_01+current_face->vertex(1)->point()[1]*vector_02;
-    polygon_refined.triangles.back().vertices[2] = origin+current_face->vertex(2)->point()[0]*vector_01+current_face->vertex(2)->point()[1]*vector_02;
+  shape_refined.vertices.reserve(triangulation.number_of_vertices());
+  for (auto current_vertex = triangulation.finite_vertices_begin(); current_vertex != triangulation.finite_vertices_end(); ++current_vertex) {
+    current_vertex->info() = std::uint32_t(shape_refined.vertices.size());
+    shape_refined.vertices.push_back(Point4(current_vertex->point()[0], current_vertex->point()[1], 0.0, 0.0));
+  } for (auto current_face = triangulation.finite_faces_begin(); current_face != triangulation.finite_faces_end(); ++current_face) {
+    shape_refined.triangles.push_back(current_face->vertex(0)->info());
+    shape_refined.triangles.push_back(current_face->vertex(1)->info());
+    shape_refined.triangles.push_back(current_face->vertex(2)->info());
   }
-    
+  
+  return shape_refined;
+}
+
+void CppLink::fromPlane(const PlanarPolygon_d &polygon_planar, const Mesh_d &shape_refined, Mesh_d &polygon_refined) {
+  
+  // Project the refined mesh back, once per vertex
+  polygon_refined.vertices.resize(shape_refined.vertices.size());
+  projectFromPlane(shape_refined.vertices.data(), shape_refined.vertices.size(), polygon_planar.origin, polygon_planar.vector_01, polygon_planar.vector_02, polygon_refined.vertices.data());
+  polygon_refined.triangles = shape_refined.triangles;
+}
+
+Mesh_d CppLink::refine(Polygon_d &polygon, double ratio, double size) {
+  PlanarPolygon_d polygon_planar = toPlane(polygon);
+  Mesh_d polygon_refined;
+  fromPlane(polygon_planar, refineShape(polygon_planar.shape, ratio, size), polygon_refined);
   return polygon_refined;
 }
 
-std::vector<Edge_d> CppLink::generateEdges(std::vector<Polygon_d> &model) {
+// Shapes are compared on a grid of 2^-30, so that rounding noise from
+// toPlane() does not keep congruent polygons apart
+static double snapShapeCoordinate(double coordinate) {
+  return std::round(coordinate*1073741824.0);
+}
+
+static bool sameShape(const Polygon_d &shape, const Polygon_d &other) {
+  if (shape.vertices.size() != other.vertices.size()) return false;
+  for (std::size_t vertex = 0; vertex < shape.vertices.size(); ++vertex) {
+    if (snapShapeCoordinate(shape.vertices[vertex][0]) != snapShapeCoordinate(other.vertices[vertex][0]) ||
+        snapShapeCoordinate(shape.vertices[vertex][1]) != snapShapeCoordinate(other.vertices[vertex][1])) return false;
+  } return true;
+}
+
+static std::uint64_t hashShape(const Polygon_d &shape) {
+  std::uint64_t hash = mixBits(shape.vertices.size());
+  for (auto const &vertex : shape.vertices) {
+    hash = mixBits(hash ^ hashPoint4(Point4(snapShapeCoordinate(vertex[0]), snapShapeCoordinate(vertex[1]), 0.0, 0.0)));
+  } return hash;
+}
+
+std::vector<Mesh_d> CppLink::refine(std::vector<Polygon_d> &model, const RefinementPolicy &policy, std::size_t firstPolygon) {
+  
+  // Express every polygon in its own plane. Polygons that are congruent and
+  // listed from corresponding vertices get the same 2D shape there.
+  std::vector<PlanarPolygon_d> model_planar(model.size());
+  std::vector<double> size_of_polygon(model.size());
+  parallelFor(model.size(), [&](std::size_t index) {
+    model_planar[index] = toPlane(model[index]);
+    size_of_polygon[index] = policy.sizeOf(firstPolygon+index, model[index].vertices);
+  });
+  
+  // Group the polygons by shape and size, keeping the first polygon of every group
+  std::vector<std::size_t> shape_of_polygon(model.size());
+  std::vector<std::size_t> first_polygon_of_shape;
+  std::unordered_multimap<std::uint64_t, std::size_t> shapes_by_hash;
+  for (std::size_t index = 0; index < model.size(); ++index) {
+    std::uint64_t hash = mixBits(hashShape(model_planar[index].shape) ^ hashPoint4(Point4(size_of_polygon[index], 0.0, 0.0, 0.0)));
+    auto candidates = shapes_by_hash.equal_range(hash);
+    auto candidate = candidates.first;
+    while (candidate != candidates.second && (size_of_polygon[first_polygon_of_shape[candidate->second]] != size_of_polygon[index] ||
+                                              !sameShape(model_planar[first_polygon_of_shape[candidate->second]].shape, model_planar[index].shape))) ++candidate;
+    if (candidate != candidates.second) shape_of_polygon[index] = candidate->second;
+    else {
+      shape_of_polygon[index] = first_polygon_of_shape.size();
+      shapes_by_hash.insert(std::make_pair(hash, first_polygon_of_shape.size()));
+      first_polygon_of_shape.push_back(index);
+    }
+  }
   
-  // Generate a unique set of edges
-  std::map<CGAL::Point_d<Kernel>, std::set<CGAL::Point_d<Kernel>>> uniqueEdges;
+  // Every shape gets its own triangulation, so they can be refined independently
+  std::vector<std::shared_ptr<const Mesh_d>> shapes_refined(first_polygon_of_shape.size());
+  parallelFor(first_polygon_of_shape.size(), [&](std::size_t shape) {
+    const Polygon_d &polygon_shape = model_planar[first_polygon_of_shape[shape]].shape;
+    double size = size_of_polygon[first_polygon_of_shape[shape]];
+    if (useRefinementCache) shapes_refined[shape] = refinementCache.find(polygon_shape, policy.ratio, size);
+    if (shapes_refined[shape]) return;
+    Mesh_d shape_refined = refineShape(polygon_shape, policy.ratio, size);
+    if (useRefinementCache) shapes_refined[shape] = refinementCache.insert(polygon_shape, policy.ratio, size, std::move(shape_refined));
+    else shapes_refined[shape] = std::make_shared<const Mesh_d>(std::move(shape_refined));
+  });
+  
+  // Map each refined shape back through the basis of every polygon with that shape
+  std::vector<Mesh_d> model_refined(model.size());
+  parallelFor(model.size(), [&](std::size_t index) {
+    fromPlane(model_planar[index], *shapes_refined[shape_of_polygon[index]], model_refined[index]);
+  });
+  
+  return model_refined;
+}
+
+std::vector<Edge_d> CppLink::generateEdges(std::vector<Polygon_d> &model, const RefinementPolicy &policy) {
+  
+  // Generate a unique set of edges, stored once per pair of vertex indices regardless of direction
+  std::size_t numberOfPolygonVertices = 0;
+  for (auto const &polygon: model) numberOfPolygonVertices += polygon.vertices.size();
+  PointIndex vertexIndex(numberOfPolygonVertices);
+  EdgeSet uniqueEdges(numberOfPolygonVertices);
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> edgeVertices;
+  std::vector<std::uint32_t> polygonVertices;
   for (auto const &polygon: model) {
-    std::vector<CGAL::Point_d<Kernel>>::const_iterator previousVertex = polygon.vertices.begin();
-    std::vector<CGAL::Point_d<Kernel>>::const_iterator currentVertex = previousVertex;
-    ++currentVertex;
-    while (currentVertex != polygon.vertices.end()) {
-      uniqueEdges[*previousVertex].insert(*currentVertex);
-      ++previousVertex;
-      ++currentVertex;
-    }
+    polygonVertices.clear();
+    for (auto const &vertex: polygon.vertices) polygonVertices.push_back(vertexIndex.insert(vertex));
+    polygon.forEachEdge([&](std::size_t current, std::size_t next) {
+      std::uint32_t currentVertex = polygonVertices[current], nextVertex = polygonVertices[next];
+      if (currentVertex != nextVertex && uniqueEdges.insert(currentVertex, nextVertex)) edgeVertices.push_back(std::make_pair(currentVertex, nextVertex));
+    });
   }
   
-  std::vector<Edge_d> edges;
-  CGAL::Vector_d<Kernel>::FT splitEvery = 0.1;
-  
-  for (auto const &edgeStart: uniqueEdges) {
-    for (auto const &edgeEnd: edgeStart.second) {
-//      std::cout << "Start: " << edgeStart.first << std::endl;
-//      std::cout << "End: " << edgeEnd << std::endl;
-      CGAL::Vector_d<Kernel> edge = edgeEnd-edgeStart.first;
-      CGAL::Vector_d<Kernel>::FT edgeNorm = sqrt(edge.squared_length());
-//      std::cout << "Edge vector: " << edge << " with norm: " << edgeNorm << std::endl;
-      CGAL::Vector_d<Kernel> edgeIncrement = (splitEvery/edgeNorm)*edge;
-      unsigned int increments = floor(edgeNorm/splitEvery);
-//      std::cout << "Increment vector: " << edgeIncrement << " with norm: " << sqrt(edgeIncrement.squared_length()) << std::endl;
-//      std::cout << "Increments: " << increments << std::endl;
-      edges.push_back(Edge_d());
+  std::vector<Edge_d> edges(edgeVertices.size());
+  
+  // Split every edge into segments of at most the policy's edge length at their start
+  parallelFor(edgeVertices.size(), [&](std::size_t index) {
+    const Point4 &edgeStart = vertexIndex.points[edgeVertices[index].first];
+    const Point4 &edgeEnd = vertexIndex.points[edgeVertices[index].second];
+    Vector4 edge = edgeEnd-edgeStart;
+    double edgeNorm = sqrt(edge.squared_length());
+    if (!policy.adaptive) {
+      Vector4 edgeIncrement = (policy.edgeLength/edgeNorm)*edge;
+      unsigned int increments = floor(edgeNorm/policy.edgeLength);
+      edges[index].vertices.reserve(increments+2);
       for (unsigned int currentIncrement = 0; currentIncrement <= increments; ++currentIncrement) {
-        edges.back().vertices.push_back(edgeStart.first+currentIncrement*edgeIncrement);
-//        std::cout << "\t" << edges.back().vertices.back() << std::endl;
-      } if (edges.back().vertices.back() != edgeEnd) {
-        edges.back().vertices.push_back(edgeEnd);
-//        std::cout << "\t" << edges.back().vertices.back() << std::endl;
+        edges[index].vertices.push_back(edgeStart+currentIncrement*edgeIncrement);
       }
+    } else {
+      Point4 currentPoint = edgeStart;
+      for (double travelled = 0.0; travelled < edgeNorm*(1.0-1e-9); travelled += policy.edgeLengthAt(currentPoint)) {
+        currentPoint = edgeStart+(travelled/edgeNorm)*edge;
+        edges[index].vertices.push_back(currentPoint);
+      }
+    } if (edges[index].vertices.empty() || edges[index].vertices.back() != edgeEnd) {
+      edges[index].vertices.push_back(edgeEnd);
     }
-  }
+  });
   
   return edges;
 }
 
-std::vector<CGAL::Point_d<Kernel>> CppLink::generateVertices(std::vector<Polygon_d> &model) {
-  std::vector<CGAL::Point_d<Kernel>> vertices;
-  std::set<CGAL::Point_d<Kernel>> uniqueVertices;
+std::vector<Point4> CppLink::generateVertices(std::vector<Polygon_d> &model) {
+  std::size_t numberOfPolygonVertices = 0;
+  for (auto const &polygon: model) numberOfPolygonVertices += polygon.vertices.size();
+  PointIndex uniqueVertices(numberOfPolygonVertices);
   for (auto const &polygon: model) {
     for (auto const &vertex: polygon.vertices) {
       uniqueVertices.insert(vertex);
-      vertices.push_back(vertex);
     }
-  } return vertices;
+  } return uniqueVertices.points;
+}
+
+void CppLink::load(Model_d &model) {
+  std::vector<Mesh_d> meshes;
+  timings.clear();
+  timeStage("refine", [&]() {
+    meshes = refine(model.polygons, model.refinementPolicy);
+  });
+  loadRefined(model, meshes);
+}
+
+bool CppLink::load(ModelReader &reader, Model_d &model, std::size_t polygonsPerBatch) {
+  std::vector<Mesh_d> meshes;
+  model.polygons.clear();
+  model.materialOfFace.clear();
+  model.materials = reader.materials;
+  timings.clear();
+  
+  bool read = true;
+  try {
+    
+    // The face count was checked against the file size, but only so much of it
+    // is reserved up front in case the faces are much larger than the minimum
+    std::size_t expectedFaces = std::min(reader.faces(), std::size_t(1) << 20);
+    model.polygons.reserve(expectedFaces);
+    model.materialOfFace.reserve(expectedFaces);
+    meshes.reserve(expectedFaces);
+    timeStage("read and refine", [&]() {
+      std::vector<Polygon_d> batch, nextBatch;
+      std::vector<std::uint32_t> nextMaterials;
+      read = reader.read(polygonsPerBatch, batch, model.materialOfFace);
+      while (read && !batch.empty()) {
+        
+        // Parse the next batch on another thread while this one is refined
+        std::future<bool> parsing = std::async(std::launch::async, [&]() {
+          return reader.read(polygonsPerBatch, nextBatch, nextMaterials);
+        });
+        std::vector<Mesh_d> batchMeshes = refine(batch, model.refinementPolicy, model.polygons.size());
+        for (auto &mesh : batchMeshes) meshes.push_back(std::move(mesh));
+        for (auto &polygon : batch) model.polygons.push_back(std::move(polygon));
+        read = parsing.get();
+        
+        batch.clear();
+        std::swap(batch, nextBatch);
+        model.materialOfFace.insert(model.materialOfFace.end(), nextMaterials.begin(), nextMaterials.end());
+        nextMaterials.clear();
+      }
+    });
+    if (!read) return false;
+    
+    loadRefined(model, meshes);
+  } catch (const std::bad_alloc &) {
+    reader.error = "out of memory";
+    return false;
+  } return true;
+}
+
+void CppLink::loadRefined(Model_d &model, const std::vector<Mesh_d> &meshes) {
+  std::vector<Edge_d> edges;
+  std::vector<Point4> corners;
+  timeStage("edges", [&]() {
+    edges = generateEdges(model.polygons, model.refinementPolicy);
+  });
+  timeStage("vertices", [&]() {
+    corners = generateVertices(model.polygons);
+  });
+  timeStage("weld", [&]() {
+    geometry.assign(meshes, model.materialOfFace, model.materials, edges, corners, weldingEpsilon);
+  });
+  geometryFile.close();
+  geometryView = geometry.view();
+}
+
+std::size_t CppLink::numberOfFaceVertices() const {
+  return geometryView.triangles.size();
+}
+
+void CppLink::copyFaceVertices(Vertex4 *destination) const {
+  parallelFor(geometryView.numberOfFaces(), [&](std::size_t face) {
+    const Float4 &colour = geometryView.materialColours[geometryView.faceMaterials[face]];
+    for (std::uint32_t triangleVertex = geometryView.faceOffsets[face]; triangleVertex < geometryView.faceOffsets[face+1]; ++triangleVertex) {
+      destination[triangleVertex].position = geometryView.vertices[geometryView.triangles[triangleVertex]];
+      destination[triangleVertex].colour = colour;
+    }
+  });
+}
+
+std::size_t CppLink::numberOfEdges() const {
+  return geometryView.numberOfEdges();
+}
+
+void CppLink::copyEdgeVertexCounts(std::uint32_t *destination) const {
+  for (std::size_t edge = 0; edge < geometryView.numberOfEdges(); ++edge) *destination++ = geometryView.edgeOffsets[edge+1]-geometryView.edgeOffsets[edge];
+}
+
+std::size_t CppLink::numberOfEdgeVertices() const {
+  return geometryView.edgeVertices.size();
+}
+
+void CppLink::copyEdgeVertices(Vertex4 *destination) const {
+  parallelFor(geometryView.numberOfEdges(), [&](std::size_t edge) {
+    for (std::uint32_t edgeVertex = geometryView.edgeOffsets[edge]; edgeVertex < geometryView.edgeOffsets[edge+1]; ++edgeVertex) {
+      destination[edgeVertex].position = geometryView.vertices[geometryView.edgeVertices[edgeVertex]];
+      destination[edgeVertex].colour = edgeColour;
+    }
+  });
+}
+
+void CppLink::copyEdgeVertexSegmentIndices(std::uint32_t *destination, std::uint32_t first) const {
+  for (std::size_t edge = 0; edge < geometryView.numberOfEdges(); ++edge) {
+    for (std::uint32_t edgeVertex = geometryView.edgeOffsets[edge]+1; edgeVertex < geometryView.edgeOffsets[edge+1]; ++edgeVertex) {
+      *destination++ = first+edgeVertex-1;
+      *destination++ = first+edgeVertex;
+    }
+  }
+}
+
+std::size_t CppLink::numberOfVertices() const {
+  return geometryView.corners.size();
+}
+
+void CppLink::copyVertices(Vertex4 *destination) const {
+  for (auto const &corner : geometryView.corners) {
+    destination->position = geometryView.vertices[corner];
+    destination->colour = vertexColour;
+    ++destination;
+  }
+}
+
+std::size_t CppLink::numberOfPositions() const {
+  return geometryView.vertices.size();
+}
+
+void CppLink::copyPositions(Float4 *destination) const {
+  std::copy(geometryView.vertices.begin(), geometryView.vertices.end(), destination);
+}
+
+std::size_t CppLink::numberOfTriangleIndices() const {
+  return geometryView.triangles.size();
+}
+
+void CppLink::copyTriangleIndices(std::uint32_t *destination) const {
+  std::copy(geometryView.triangles.begin(), geometryView.triangles.end(), destination);
+}
+
+std::size_t CppLink::numberOfEdgeSegmentIndices() const {
+  return 2*geometryView.numberOfEdgeSegments();
+}
+
+void CppLink::copyEdgeSegmentIndices(std::uint32_t *destination) const {
+  for (std::size_t edge = 0; edge < geometryView.numberOfEdges(); ++edge) {
+    for (std::uint32_t edgeVertex = geometryView.edgeOffsets[edge]+1; edgeVertex < geometryView.edgeOffsets[edge+1]; ++edgeVertex) {
+      *destination++ = geometryView.edgeVertices[edgeVertex-1];
+      *destination++ = geometryView.edgeVertices[edgeVertex];
+    }
+  }
 }
 
 Mesh_d CppLink::triangulateUsingBarycentre(Polygon_d &polygon) {
@@ -132,23 +425,20 @@ Mesh_d CppLink::triangulateUsingBarycentre(Polygon_d &polygon) {
     }
   } for (unsigned int currentCoordinate = 0; currentCoordinate < 4; ++currentCoordinate) {
     centroid[currentCoordinate] /= polygon.vertices.size();
-  } CGAL::Point_d<Kernel> centroidPoint(4, centroid, centroid+4);
-  
-  // Barycentric triangulation
-  std::vector<CGAL::Point_d<Kernel>>::const_iterator previousPoint = polygon.vertices.begin();
-  std::vector<CGAL::Point_d<Kernel>>::const_iterator currentPoint = previousPoint;
-  ++currentPoint;
-  while (currentPoint != polygon.vertices.end()) {
-    polygon_triangulated.triangles.push_back(Triangle_d());
-    polygon_triangulated.triangles.back().vertices[0] = centroidPoint;
-    polygon_triangulated.triangles.back().vertices[1] = *previousPoint;
-    polygon_triangulated.triangles.back().vertices[2] = *currentPoint;
-    ++previousPoint;
-    ++currentPoint;
-  } polygon_triangulated.triangles.push_back(Triangle_d());
-  polygon_triangulated.triangles.back().vertices[0] = centroidPoint;
-  polygon_triangulated.triangles.back().vertices[1] = polygon.vertices.back();
-  polygon_triangulated.triangles.back().vertices[2] = polygon.vertices.front();
+  }
+  
+  // The centroid is vertex 0, followed by the polygon's own vertices
+  polygon_triangulated.vertices.reserve(polygon.vertices.size()+1);
+  polygon_triangulated.vertices.push_back(Point4(centroid));
+  polygon_triangulated.vertices.insert(polygon_triangulated.vertices.end(), polygon.vertices.begin(), polygon.vertices.end());
+  
+  // Barycentric triangulation, one triangle per edge
+  polygon_triangulated.triangles.reserve(3*polygon.vertices.size());
+  polygon.forEachEdge([&](std::size_t current, std::size_t next) {
+    polygon_triangulated.triangles.push_back(0);
+    polygon_triangulated.triangles.push_back(std::uint32_t(current+1));
+    polygon_triangulated.triangles.push_back(std::uint32_t(next+1));
+  });
   
   return polygon_triangulated;
 }
@@ -156,64 +446,31 @@ Mesh_d CppLink::triangulateUsingBarycentre(Polygon_d &polygon) {
 Mesh_d CppLink::triangulateQuad(Polygon_d &polygon) {
   
   Mesh_d polygon_triangulated;
-  
-  // Barycentric triangulation
-  CGAL::Point_d<Kernel> points[4];
-  for (unsigned int currentIndex = 0; currentIndex < 4; ++currentIndex) {
-    points[currentIndex] = polygon.vertices[currentIndex];
-  }
-  
-  polygon_triangulated.triangles.push_back(Triangle_d());
-  polygon_triangulated.triangles.back().vertices[0] = points[0];
-  polygon_triangulated.triangles.back().vertices[1] = points[1];
-  polygon_triangulated.triangles.back().vertices[2] = points[2];
-  
-  polygon_triangulated.triangles.push_back(Triangle_d());
-  polygon_triangulated.triangles.back().vertices[0] = points[2];
-  polygon_triangulated.triangles.back().vertices[1] = points[3];
-  polygon_triangulated.triangles.back().vertices[2] = points[0];
+  polygon_triangulated.vertices.assign(polygon.vertices.begin(), polygon.vertices.begin()+4);
+  polygon_triangulated.triangles = {0, 1, 2, 2, 3, 0};
   
   return polygon_triangulated;
 }
 
-void CppLink::makeTesseract() {
+Model_d CppLink::generateTesseract() {
   std::vector<Polygon_d> tesseract;
   
-  double coordinates_0000[4] = {-1, -1, -1, -1};
-  double coordinates_0001[4] = {-1, -1, -1, +1};
-  double coordinates_0010[4] = {-1, -1, +1, -1};
-  double coordinates_0011[4] = {-1, -1, +1, +1};
-  double coordinates_0100[4] = {-1, +1, -1, -1};
-  double coordinates_0101[4] = {-1, +1, -1, +1};
-  double coordinates_0110[4] = {-1, +1, +1, -1};
-  double coordinates_0111[4] = {-1, +1, +1, +1};
-  double coordinates_1000[4] = {+1, -1, -1, -1};
-  double coordinates_1001[4] = {+1, -1, -1, +1};
-  double coordinates_1010[4] = {+1, -1, +1, -1};
-  double coordinates_1011[4] = {+1, -1, +1, +1};
-  double coordinates_1100[4] = {+1, +1, -1, -1};
-  double coordinates_1101[4] = {+1, +1, -1, +1};
-  double coordinates_1110[4] = {+1, +1, +1, -1};
-  double coordinates_1111[4] = {+1, +1, +1, +1};
-  
-  
-  
-  CGAL::Point_d<Kernel> point_0000(4, coordinates_0000, coordinates_0000+4);
-  CGAL::Point_d<Kernel> point_0001(4, coordinates_0001, coordinates_0001+4);
-  CGAL::Point_d<Kernel> point_0010(4, coordinates_0010, coordinates_0010+4);
-  CGAL::Point_d<Kernel> point_0011(4, coordinates_0011, coordinates_0011+4);
-  CGAL::Point_d<Kernel> point_0100(4, coordinates_0100, coordinates_0100+4);
-  CGAL::Point_d<Kernel> point_0101(4, coordinates_0101, coordinates_0101+4);
-  CGAL::Point_d<Kernel> point_0110(4, coordinates_0110, coordinates_0110+4);
-  CGAL::Point_d<Kernel> point_0111(4, coordinates_0111, coordinates_0111+4);
-  CGAL::Point_d<Kernel> point_1000(4, coordinates_1000, coordinates_1000+4);
-  CGAL::Point_d<Kernel> point_1001(4, coordinates_1001, coordinates_1001+4);
-  CGAL::Point_d<Kernel> point_1010(4, coordinates_1010, coordinates_1010+4);
-  CGAL::Point_d<Kernel> point_1011(4, coordinates_1011, coordinates_1011+4);
-  CGAL::Point_d<Kernel> point_1100(4, coordinates_1100, coordinates_1100+4);
-  CGAL::Point_d<Kernel> point_1101(4, coordinates_1101, coordinates_1101+4);
-  CGAL::Point_d<Kernel> point_1110(4, coordinates_1110, coordinates_1110+4);
-  CGAL::Point_d<Kernel> point_1111(4, coordinates_1111, coordinates_1111+4);
+  Point4 point_0000(-1, -1, -1, -1);
+  Point4 point_0001(-1, -1, -1, +1);
+  Point4 point_0010(-1, -1, +1, -1);
+  Point4 point_0011(-1, -1, +1, +1);
+  Point4 point_0100(-1, +1, -1, -1);
+  Point4 point_0101(-1, +1, -1, +1);
+  Point4 point_0110(-1, +1, +1, -1);
+  Point4 point_0111(-1, +1, +1, +1);
+  Point4 point_1000(+1, -1, -1, -1);
+  Point4 point_1001(+1, -1, -1, +1);
+  Point4 point_1010(+1, -1, +1, -1);
+  Point4 point_1011(+1, -1, +1, +1);
+  Point4 point_1100(+1, +1, -1, -1);
+  Point4 point_1101(+1, +1, -1, +1);
+  Point4 point_1110(+1, +1, +1, -1);
+  Point4 point_1111(+1, +1, +1, +1);
   
   // ffvv
   
@@ -371,20 +628,17 @@ void CppLink::makeTesseract() {
   tesseract.back().vertices.push_back(point_1111);
   tesseract.back().vertices.push_back(point_1011);
   
-  std::vector<Mesh_d> tesseract_refined;
-  for (auto &polygon : tesseract) {
-    tesseract_refined.push_back(refine(polygon, 0.125, 0.1));
-//    tesseract_refined.push_back(triangulateQuad(polygon));
-    tesseract_refined.back().colour[0] = 0.0;
-    tesseract_refined.back().colour[1] = 0.0;
-    tesseract_refined.back().colour[2] = 1.0;
-    tesseract_refined.back().colour[3] = 0.2;
-  } faces = tesseract_refined;
-  edges = generateEdges(tesseract);
-  vertices = generateVertices(tesseract);
+  std::vector<Float4> materials(1, Float4(0.0, 0.0, 1.0, 0.2));
+  std::vector<std::uint32_t> materialOfFace(tesseract.size(), 0);
+  return Model_d{std::move(tesseract), std::move(materialOfFace), std::move(materials), RefinementPolicy()};
 }
 
-void CppLink::makeHouse() {
+void CppLink::makeTesseract() {
+  Model_d tesseract = generateTesseract();
+  load(tesseract);
+}
+
+Model_d CppLink::generateHouse() {
   
   std::vector<Polygon_d> house;
   
@@ -420,19 +674,19 @@ void CppLink::makeHouse() {
     {0.75, -1, -0.5, 1} // 24 -- window 1
   };
   
-  std::map<int, std::tuple<double, double, double>> materials;
-  std::vector<int> materialOfFace;
-  materials[0] = std::tuple<double, double, double>(0.7, 0.7, 0.7); // 0 -- walls
-  materials[1] = std::tuple<double, double, double>(1.0, 0.0, 0.0); // 1 -- roof
-  materials[2] = std::tuple<double, double, double>(0.7, 0.35, 0.17); // 2 -- door
-  materials[3] = std::tuple<double, double, double>(0.0, 1.0, 0.0); // 3 -- grass
-  materials[4] = std::tuple<double, double, double>(0.0, 1.0, 0.0); // 4 -- base
-  materials[5] = std::tuple<double, double, double>(0.0, 0.0, 0.0); // 5 -- edges
-  materials[6] = std::tuple<double, double, double>(0.3, 0.3, 1.0); // 6 -- window
-  
-  std::vector<CGAL::Point_d<Kernel>> points;
+  std::vector<Float4> materials;
+  std::vector<std::uint32_t> materialOfFace;
+  materials.push_back(Float4(0.7, 0.7, 0.7, 0.2)); // 0 -- walls
+  materials.push_back(Float4(1.0, 0.0, 0.0, 0.2)); // 1 -- roof
+  materials.push_back(Float4(0.7, 0.35, 0.17, 0.2)); // 2 -- door
+  materials.push_back(Float4(0.0, 1.0, 0.0, 0.2)); // 3 -- grass
+  materials.push_back(Float4(0.0, 1.0, 0.0, 0.2)); // 4 -- base
+  materials.push_back(Float4(0.0, 0.0, 0.0, 0.2)); // 5 -- edges
+  materials.push_back(Float4(0.3, 0.3, 1.0, 0.2)); // 6 -- window
+  
+  std::vector<Point4> points;
   for (int i = 0; i < 25; ++i) {
-    points.push_back(CGAL::Point_d<Kernel>(4, point_coordinates[i], point_coordinates[i]+4));
+    points.push_back(Point4(point_coordinates[i]));
   }
   
   // 0: Base of first house
@@ -775,7 +1029,7 @@ void CppLink::makeHouse() {
   house.back().vertices.push_back(points[17]);
   house.back().vertices.push_back(points[20]);
   
-  //39: Window
+  //40: Window
   materialOfFace.push_back(6);
   house.push_back(Polygon_d());
   house.back().vertices.push_back(points[21]);
@@ -783,48 +1037,66 @@ void CppLink::makeHouse() {
   house.back().vertices.push_back(points[23]);
   house.back().vertices.push_back(points[24]);
   
-  //40: Window left edge collapses
+  //41: Window left edge collapses
   materialOfFace.push_back(6);
   house.push_back(Polygon_d());
   house.back().vertices.push_back(points[21]);
   house.back().vertices.push_back(points[22]);
   house.back().vertices.push_back(points[1]);
   
-  //41: Window top edge collapses
+  //42: Window top edge collapses
   materialOfFace.push_back(6);
   house.push_back(Polygon_d());
   house.back().vertices.push_back(points[22]);
   house.back().vertices.push_back(points[23]);
   house.back().vertices.push_back(points[1]);
   
-  //42: Window right edge collapses
+  //43: Window right edge collapses
   materialOfFace.push_back(6);
   house.push_back(Polygon_d());
   house.back().vertices.push_back(points[23]);
   house.back().vertices.push_back(points[24]);
   house.back().vertices.push_back(points[1]);
   
-  //43: Window bottom edge collapses
+  //44: Window bottom edge collapses
   materialOfFace.push_back(6);
   house.push_back(Polygon_d());
   house.back().vertices.push_back(points[24]);
   house.back().vertices.push_back(points[21]);
   house.back().vertices.push_back(points[1]);
   
-  std::vector<Mesh_d> houseRefined;
-  for (unsigned int index = 0; index < house.size(); ++index) {
-    houseRefined.push_back(refine(house[index], 0.125, 0.1));
-//    houseRefined(triangulateQuad(house[index]));
-    houseRefined.back().colour[0] = std::get<0>(materials[materialOfFace[index]]);
-    houseRefined.back().colour[1] = std::get<1>(materials[materialOfFace[index]]);
-    houseRefined.back().colour[2] = std::get<2>(materials[materialOfFace[index]]);
-    houseRefined.back().colour[3] = 0.2;
-  } faces = houseRefined;
-  edges = generateEdges(house);
-  vertices = generateVertices(house);
+  return Model_d{std::move(house), std::move(materialOfFace), std::move(materials), RefinementPolicy()};
 }
 
-void CppLink::makeCorridor() {
+void CppLink::makeHouse() {
+  Model_d house = generateHouse();
+  load(house);
+}
+
+bool CppLink::makeFromFile(const std::string &path, std::string &error) {
+  ModelReader reader;
+  Model_d model;
+  if (!reader.open(path) || !load(reader, model)) {
+    error = reader.error;
+    return false;
+  } return true;
+}
+
+bool CppLink::makeFromGeometryFile(const std::string &path, std::string &error) {
+  geometry = GeometryBuffer();
+  geometryView = GeometryView();
+  if (!geometryFile.open(path)) {
+    error = geometryFile.error;
+    return false;
+  } geometryView = geometryFile.view();
+  return true;
+}
+
+bool CppLink::writeGeometryFile(const std::string &path) const {
+  return GeometryFile::write(path, geometryView);
+}
+
+Model_d CppLink::generateCorridor() {
   
   std::vector<Polygon_d> corridor;
   
@@ -884,15 +1156,15 @@ void CppLink::makeCorridor() {
     {0.00, -0.4, +0.67, +0.67}, // 47 -- top of corridor
   };
   
-  std::map<int, std::tuple<double, double, double>> materials;
-  std::vector<int> materialOfFace;
-  materials[0] = std::tuple<double, double, double>(0.0, 1.0, 0.0); // 0 -- left building
-  materials[1] = std::tuple<double, double, double>(0.0, 0.0, 1.0); // 1 -- right building
-  materials[2] = std::tuple<double, double, double>(1.0, 0.0, 0.0); // 2 -- corridor
+  std::vector<Float4> materials;
+  std::vector<std::uint32_t> materialOfFace;
+  materials.push_back(Float4(0.0, 1.0, 0.0, 0.2)); // 0 -- left building
+  materials.push_back(Float4(0.0, 0.0, 1.0, 0.2)); // 1 -- right building
+  materials.push_back(Float4(1.0, 0.0, 0.0, 0.2)); // 2 -- corridor
   
-  std::vector<CGAL::Point_d<Kernel>> points;
+  std::vector<Point4> points;
   for (int i = 0; i < 48; ++i) {
-    points.push_back(CGAL::Point_d<Kernel>(4, point_coordinates[i], point_coordinates[i]+4));
+    points.push_back(Point4(point_coordinates[i]));
   }
   
   // 0: Base of left building at t_0
@@ -1471,15 +1743,10 @@ void CppLink::makeCorridor() {
   corridor.back().vertices.push_back(points[47]);
   corridor.back().vertices.push_back(points[45]);
   
-  std::vector<Mesh_d> corridorRefined;
-  for (unsigned int index = 0; index < corridor.size(); ++index) {
-    corridorRefined.push_back(refine(corridor[index], 0.125, 0.1));
-    //    corridorRefined(triangulateQuad(house[index]));
-    corridorRefined.back().colour[0] = std::get<0>(materials[materialOfFace[index]]);
-    corridorRefined.back().colour[1] = std::get<1>(materials[materialOfFace[index]]);
-    corridorRefined.back().colour[2] = std::get<2>(materials[materialOfFace[index]]);
-    corridorRefined.back().colour[3] = 0.2;
-  } faces = corridorRefined;
-  edges = generateEdges(corridor);
-  vertices = generateVertices(corridor);
+  return Model_d{std::move(corridor), std::move(materialOfFace), std::move(materials), RefinementPolicy()};
+}
+
+void CppLink::makeCorridor() {
+  Model_d corridor = generateCorridor();
+  load(corridor);
 }
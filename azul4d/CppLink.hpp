@@ -17,7 +17,14 @@
 #ifndef CppLink_hpp
 #define CppLink_hpp
 
+#include <chrono>
+#include <cstdint>
 #include <list>
+#include <memory>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
@@ -26,56 +33,160 @@
 #include <CGAL/Delaunay_mesher_2.h>
 #include <CGAL/Delaunay_mesh_face_base_2.h>
 #include <CGAL/Delaunay_mesh_size_criteria_2.h>
-#include <CGAL/aff_transformation_tags.h>
-#include <CGAL/predicates_d.h>
-#include <CGAL/constructions_d.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
+
+#include "Geometry4.hpp"
+#include "GeometryFile.hpp"
+#include "GeometryView.hpp"
+#include "HashTables.hpp"
+#include "Model.hpp"
+#include "ModelReader.hpp"
+#include "Parallel.hpp"
+#include "PlaneProjection.hpp"
+#include "RefinementCache.hpp"
 
-typedef CGAL::Cartesian_d<double> Kernel;
 typedef CGAL::Exact_predicates_inexact_constructions_kernel Triangulation_kernel;
 
-typedef CGAL::Triangulation_vertex_base_2<Triangulation_kernel> Vertex_base;
+typedef CGAL::Triangulation_vertex_base_with_info_2<std::uint32_t, Triangulation_kernel> Vertex_base;
 typedef CGAL::Delaunay_mesh_face_base_2<Triangulation_kernel> Face_base;
 typedef CGAL::Triangulation_data_structure_2<Vertex_base, Face_base> TDS;
 typedef CGAL::Constrained_Delaunay_triangulation_2<Triangulation_kernel, TDS> CDT;
 
-struct Polygon_d {
-  std::vector<CGAL::Point_d<Kernel>> vertices;
-};
+// Compatibility with code still written against the dD kernel
+typedef CGAL::Cartesian_d<double> Kernel;
+
+inline Point4 toPoint4(const CGAL::Point_d<Kernel> &point) {
+  return Point4(point.cartesian(0), point.cartesian(1), point.cartesian(2), point.cartesian(3));
+}
+
+inline CGAL::Point_d<Kernel> toPoint_d(const Point4 &point) {
+  return CGAL::Point_d<Kernel>(4, point.coordinates, point.coordinates+4);
+}
 
-struct Triangle_d {
-  CGAL::Point_d<Kernel> vertices[3];
+// A polygon in an orthonormal basis of its own plane: vertex i is
+// origin+shape.vertices[i][0]*vector_01+shape.vertices[i][1]*vector_02, and
+// the last two coordinates of the shape are always 0
+struct PlanarPolygon_d {
+  Point4 origin;
+  Vector4 vector_01;
+  Vector4 vector_02;
+  Polygon_d shape;
 };
 
-struct Mesh_d {
-  std::vector<Triangle_d> triangles;
-  float colour[4];
+// All the geometry of a model, with every distinct 4D vertex stored once in
+// vertices and referred to by index everywhere else:
+// - face i consists of the triangles in triangles[faceOffsets[i]] to
+//   triangles[faceOffsets[i+1]-1], three indices per triangle, and is drawn
+//   with materialColours[faceMaterials[i]]
+// - edge i is the polyline through edgeVertices[edgeOffsets[i]] to
+//   edgeVertices[edgeOffsets[i+1]-1]
+// - corners are the vertices of the original polygons
+struct GeometryBuffer {
+  std::vector<Float4> vertices;
+  std::vector<std::uint32_t> triangles;
+  std::vector<std::uint32_t> faceOffsets;
+  std::vector<std::uint32_t> faceMaterials;
+  std::vector<Float4> materialColours;
+  std::vector<std::uint32_t> edgeVertices;
+  std::vector<std::uint32_t> edgeOffsets;
+  std::vector<std::uint32_t> corners;
+  
+  GeometryView view() const {
+    return GeometryView{vertices, triangles, faceOffsets, faceMaterials, materialColours, edgeVertices, edgeOffsets, corners};
+  }
+  
+  // Welds the vertices of all meshes, edges and corners together. Vertices
+  // closer than epsilon might be merged; 0 only merges identical ones.
+  void assign(const std::vector<Mesh_d> &meshes, const std::vector<std::uint32_t> &materialOfFace, const std::vector<Float4> &materials,
+              const std::vector<Edge_d> &edges, const std::vector<Point4> &cornerPoints, double epsilon);
 };
 
-struct Edge_d {
-  std::vector<CGAL::Point_d<Kernel>> vertices;
+// Wall-clock duration of a processing stage
+struct StageTiming {
+  const char *stage;
+  double seconds;
 };
 
 class CppLink {
 public:
-  std::vector<Mesh_d> faces;
-  std::vector<Edge_d> edges;
-  std::vector<CGAL::Point_d<Kernel>> vertices;
-  std::vector<Mesh_d>::const_iterator currentFace;
-  std::vector<Edge_d>::const_iterator currentEdge;
-  std::vector<CGAL::Point_d<Kernel>>::const_iterator currentVertex;
-  std::vector<Triangle_d>::const_iterator currentFaceTriangle;
-  std::vector<CGAL::Point_d<Kernel>>::const_iterator currentEdgeVertex;
-  float currentPointCoordinates[4];
+  GeometryBuffer geometry;
+  // What the copy* functions read: geometry after load() or the arrays of
+  // geometryFile after makeFromGeometryFile()
+  GeometryView geometryView;
+  GeometryFile geometryFile;
+  double weldingEpsilon = 0.0;
+  RefinementCache refinementCache;
+  // Off by default, since the cache keeps a copy of every distinct refined
+  // shape in memory for as long as this CppLink
+  bool useRefinementCache = false;
+  Float4 edgeColour = Float4(0.0, 0.0, 0.0, 1.0);
+  Float4 vertexColour = Float4(0.0, 0.0, 0.0, 1.0);
+  std::vector<StageTiming> timings;
+  
+  template <class Function>
+  void timeStage(const char *stage, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    timings.push_back(StageTiming{stage, std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()});
+  }
   
+  PlanarPolygon_d toPlane(const Polygon_d &polygon);
+  Mesh_d refineShape(const Polygon_d &shape, double ratio, double size);
+  void fromPlane(const PlanarPolygon_d &polygon_planar, const Mesh_d &shape_refined, Mesh_d &polygon_refined);
   Mesh_d refine(Polygon_d &polygon, double ratio, double size);
+  // Refines each distinct shape once and maps it back to all the polygons
+  // congruent to it. Shapes are looked up in refinementCache first, unless
+  // useRefinementCache is false. model holds the polygons of the whole model
+  // starting at firstPolygon, which is where policy's per-polygon sizes are
+  // looked up.
+  std::vector<Mesh_d> refine(std::vector<Polygon_d> &model, const RefinementPolicy &policy, std::size_t firstPolygon = 0);
   Mesh_d triangulateUsingBarycentre(Polygon_d &polygon);
   Mesh_d triangulateQuad(Polygon_d &polygon);
-  std::vector<Edge_d> generateEdges(std::vector<Polygon_d> &model);
-  std::vector<CGAL::Point_d<Kernel>> generateVertices(std::vector<Polygon_d> &model);
+  std::vector<Edge_d> generateEdges(std::vector<Polygon_d> &model, const RefinementPolicy &policy);
+  std::vector<Point4> generateVertices(std::vector<Polygon_d> &model);
+  void load(Model_d &model);
+  // Reads the faces of an open reader into model, refining every batch of
+  // polygons while the next one is parsed, and then finishes like
+  // load(model). Returns false if the file is malformed, as in reader.error.
+  bool load(ModelReader &reader, Model_d &model, std::size_t polygonsPerBatch = 16384);
+  
+  // Bulk export: each copy* function writes number*() consecutive elements
+  // into a buffer provided by the caller. Face, edge and vertex copies have
+  // one record per use of a vertex; the indexed copies refer to positions.
+  std::size_t numberOfFaceVertices() const;
+  void copyFaceVertices(Vertex4 *destination) const;
+  std::size_t numberOfEdges() const;
+  void copyEdgeVertexCounts(std::uint32_t *destination) const;
+  std::size_t numberOfEdgeVertices() const;
+  void copyEdgeVertices(Vertex4 *destination) const;
+  // Pairs of indices of consecutive copyEdgeVertices records, plus first,
+  // which turn the edge polylines into a line list
+  void copyEdgeVertexSegmentIndices(std::uint32_t *destination, std::uint32_t first) const;
+  std::size_t numberOfVertices() const;
+  void copyVertices(Vertex4 *destination) const;
+  std::size_t numberOfPositions() const;
+  void copyPositions(Float4 *destination) const;
+  std::size_t numberOfTriangleIndices() const;
+  void copyTriangleIndices(std::uint32_t *destination) const;
+  std::size_t numberOfEdgeSegmentIndices() const;
+  void copyEdgeSegmentIndices(std::uint32_t *destination) const;
+  
+  Model_d generateTesseract();
+  Model_d generateHouse();
+  Model_d generateCorridor();
   
   void makeTesseract();
   void makeHouse();
   void makeCorridor();
+  // Loads a 4OFF file, returning false and setting error if it fails
+  bool makeFromFile(const std::string &path, std::string &error);
+  // Maps geometry saved with writeGeometryFile() without refining anything
+  bool makeFromGeometryFile(const std::string &path, std::string &error);
+  bool writeGeometryFile(const std::string &path) const;
+  
+private:
+  // Everything in load() after the refinement
+  void loadRefined(Model_d &model, const std::vector<Mesh_d> &meshes);
 };
 
 #endif /* CppLink_hpp */
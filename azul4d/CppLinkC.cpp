@@ -0,0 +1,128 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "CppLinkC.h"
+#include "CppLink.hpp"
+
+static CppLink *cppLink(CppLinkHandle *handle) {
+  return reinterpret_cast<CppLink *>(handle);
+}
+
+static const CppLink *cppLink(const CppLinkHandle *handle) {
+  return reinterpret_cast<const CppLink *>(handle);
+}
+
+CppLinkHandle *cppLinkCreate(void) {
+  return reinterpret_cast<CppLinkHandle *>(new CppLink());
+}
+
+void cppLinkDestroy(CppLinkHandle *handle) {
+  delete cppLink(handle);
+}
+
+void cppLinkMakeTesseract(CppLinkHandle *handle) {
+  cppLink(handle)->makeTesseract();
+}
+
+void cppLinkMakeHouse(CppLinkHandle *handle) {
+  cppLink(handle)->makeHouse();
+}
+
+void cppLinkMakeCorridor(CppLinkHandle *handle) {
+  cppLink(handle)->makeCorridor();
+}
+
+int cppLinkMakeFromFile(CppLinkHandle *handle, const char *path) {
+  std::string error;
+  return cppLink(handle)->makeFromFile(path, error) ? 1 : 0;
+}
+
+size_t cppLinkNumberOfFaceVertices(const CppLinkHandle *handle) {
+  return cppLink(handle)->numberOfFaceVertices();
+}
+
+void cppLinkCopyFaceVertices(const CppLinkHandle *handle, void *destination) {
+  cppLink(handle)->copyFaceVertices(static_cast<Vertex4 *>(destination));
+}
+
+size_t cppLinkNumberOfEdges(const CppLinkHandle *handle) {
+  return cppLink(handle)->numberOfEdges();
+}
+
+void cppLinkCopyEdgeVertexCounts(const CppLinkHandle *handle, uint32_t *destination) {
+  cppLink(handle)->copyEdgeVertexCounts(destination);
+}
+
+size_t cppLinkNumberOfEdgeVertices(const CppLinkHandle *handle) {
+  return cppLink(handle)->numberOfEdgeVertices();
+}
+
+void cppLinkCopyEdgeVertices(const CppLinkHandle *handle, void *destination) {
+  cppLink(handle)->copyEdgeVertices(static_cast<Vertex4 *>(destination));
+}
+
+void cppLinkCopyEdgeVertexSegmentIndices(const CppLinkHandle *handle, uint32_t *destination, uint32_t first) {
+  cppLink(handle)->copyEdgeVertexSegmentIndices(destination, first);
+}
+
+size_t cppLinkNumberOfVertices(const CppLinkHandle *handle) {
+  return cppLink(handle)->numberOfVertices();
+}
+
+void cppLinkCopyVertices(const CppLinkHandle *handle, void *destination) {
+  cppLink(handle)->copyVertices(static_cast<Vertex4 *>(destination));
+}
+
+size_t cppLinkNumberOfPositions(const CppLinkHandle *handle) {
+  return cppLink(handle)->numberOfPositions();
+}
+
+void cppLinkCopyPositions(const CppLinkHandle *handle, void *destination) {
+  cppLink(handle)->copyPositions(static_cast<Float4 *>(destination));
+}
+
+size_t cppLinkNumberOfTriangleIndices(const CppLinkHandle *handle) {
+  return cppLink(handle)->numberOfTriangleIndices();
+}
+
+void cppLinkCopyTriangleIndices(const CppLinkHandle *handle, uint32_t *destination) {
+  cppLink(handle)->copyTriangleIndices(destination);
+}
+
+size_t cppLinkNumberOfEdgeSegmentIndices(const CppLinkHandle *handle) {
+  return cppLink(handle)->numberOfEdgeSegmentIndices();
+}
+
+void cppLinkCopyEdgeSegmentIndices(const CppLinkHandle *handle, uint32_t *destination) {
+  cppLink(handle)->copyEdgeSegmentIndices(destination);
+}
+
+int cppLinkMakeFromGeometryFile(CppLinkHandle *handle, const char *path) {
+  std::string error;
+  return cppLink(handle)->makeFromGeometryFile(path, error) ? 1 : 0;
+}
+
+int cppLinkWriteGeometryFile(const CppLinkHandle *handle, const char *path) {
+  return cppLink(handle)->writeGeometryFile(path) ? 1 : 0;
+}
+
+const void *cppLinkPositions(const CppLinkHandle *handle) {
+  return cppLink(handle)->geometryView.vertices.data();
+}
+
+const uint32_t *cppLinkTriangleIndices(const CppLinkHandle *handle) {
+  return cppLink(handle)->geometryView.triangles.data();
+}
@@ -0,0 +1,72 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CppLinkC_h
+#define CppLinkC_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Plain C interface to CppLink, for callers that cannot use C++ directly.
+// Vertices are written as interleaved {float4 position, float4 colour}
+// records, 32 bytes each, into buffers owned by the caller.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CppLinkHandle CppLinkHandle;
+
+CppLinkHandle *cppLinkCreate(void);
+void cppLinkDestroy(CppLinkHandle *handle);
+
+void cppLinkMakeTesseract(CppLinkHandle *handle);
+void cppLinkMakeHouse(CppLinkHandle *handle);
+void cppLinkMakeCorridor(CppLinkHandle *handle);
+// Loads a 4OFF file, returning 0 if it cannot be read
+int cppLinkMakeFromFile(CppLinkHandle *handle, const char *path);
+
+size_t cppLinkNumberOfFaceVertices(const CppLinkHandle *handle);
+void cppLinkCopyFaceVertices(const CppLinkHandle *handle, void *destination);
+size_t cppLinkNumberOfEdges(const CppLinkHandle *handle);
+void cppLinkCopyEdgeVertexCounts(const CppLinkHandle *handle, uint32_t *destination);
+size_t cppLinkNumberOfEdgeVertices(const CppLinkHandle *handle);
+void cppLinkCopyEdgeVertices(const CppLinkHandle *handle, void *destination);
+void cppLinkCopyEdgeVertexSegmentIndices(const CppLinkHandle *handle, uint32_t *destination, uint32_t first);
+size_t cppLinkNumberOfVertices(const CppLinkHandle *handle);
+void cppLinkCopyVertices(const CppLinkHandle *handle, void *destination);
+
+// Indexed geometry: every distinct position once as a float4, plus triangle
+// and line segment index lists into it
+size_t cppLinkNumberOfPositions(const CppLinkHandle *handle);
+void cppLinkCopyPositions(const CppLinkHandle *handle, void *destination);
+size_t cppLinkNumberOfTriangleIndices(const CppLinkHandle *handle);
+void cppLinkCopyTriangleIndices(const CppLinkHandle *handle, uint32_t *destination);
+size_t cppLinkNumberOfEdgeSegmentIndices(const CppLinkHandle *handle);
+void cppLinkCopyEdgeSegmentIndices(const CppLinkHandle *handle, uint32_t *destination);
+
+// Welded geometry files, which are mapped rather than read, so that their
+// positions and triangle indices can be used in place until the next make
+int cppLinkMakeFromGeometryFile(CppLinkHandle *handle, const char *path);
+int cppLinkWriteGeometryFile(const CppLinkHandle *handle, const char *path);
+const void *cppLinkPositions(const CppLinkHandle *handle);
+const uint32_t *cppLinkTriangleIndices(const CppLinkHandle *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CppLinkC_h */
@@ -29,28 +29,24 @@ struct CppLinkWrapper;
 - (void) makeTesseract;
 - (void) makeHouse;
 - (void) makeCorridor;
-
-- (void) initialiseFacesIterator;
-- (void) advanceFacesIterator;
-- (BOOL) facesIteratorEnded;
-- (const float *)currentFaceColour;
-- (void) initialiseFaceTrianglesIterator;
-- (void) advanceFaceTrianglesIterator;
-- (BOOL) faceTrianglesIteratorEnded;
-- (const float *)currentFaceTriangleVertex: (long)index;
-
-- (void) initialiseEdgesIterator;
-- (void) advanceEdgesIterator;
-- (BOOL) edgesIteratorEnded;
-- (void) initialiseEdgeVerticesIterator;
-- (BOOL) edgeVerticesIteratorEnded;
-- (void) advanceEdgeVerticesIterator;
-- (const float *)currentEdgeVertex;
-
-- (void) initialiseVerticesIterator;
-- (void) advanceVerticesIterator;
-- (BOOL) verticesIteratorEnded;
-- (const float *)currentVertex;
+- (BOOL) makeFromFile: (NSString *)path;
+- (BOOL) makeFromGeometryFile: (NSString *)path;
+- (BOOL) writeGeometryFile: (NSString *)path;
+
+- (long) numberOfFaceVertices;
+- (void) copyFaceVertices: (void *)destination;
+- (long) numberOfEdges;
+- (void) copyEdgeVertexCounts: (unsigned int *)destination;
+- (long) numberOfEdgeVertices;
+- (void) copyEdgeVertices: (void *)destination;
+- (long) numberOfEdgeSegmentIndices;
+- (void) copyEdgeVertexSegmentIndices: (unsigned int *)destination first: (unsigned int)first;
+- (long) numberOfVertices;
+- (void) copyVertices: (void *)destination;
+
+- (void) rotateFrom: (int)first to: (int)second angle: (double)angle;
+- (void) resetRotation;
+- (void) copyTransformationMatrix: (void *)destination;
 
 - (void) dealloc;
 
@@ -16,9 +16,11 @@
 
 #import "CppLinkWrapperWrapper.h"
 #import "CppLink.hpp"
+#import "Rotation4.hpp"
 
 struct CppLinkWrapper {
   CppLink *cppLink;
+  Rotation4 rotation;
 };
 
 @implementation CppLinkWrapperWrapper
@@ -42,86 +44,76 @@ struct CppLinkWrapper {
   cppLinkWrapper->cppLink->makeCorridor();
 }
 
-- (void) initialiseFacesIterator {
-  cppLinkWrapper->cppLink->currentFace = cppLinkWrapper->cppLink->faces.begin();
+- (BOOL) makeFromFile: (NSString *)path {
+  std::string error;
+  if (!cppLinkWrapper->cppLink->makeFromFile([path UTF8String], error)) {
+    NSLog(@"%@: %s", path, error.c_str());
+    return NO;
+  } return YES;
 }
 
-- (void) advanceFacesIterator {
-  ++cppLinkWrapper->cppLink->currentFace;
+- (BOOL) makeFromGeometryFile: (NSString *)path {
+  std::string error;
+  if (!cppLinkWrapper->cppLink->makeFromGeometryFile([path UTF8String], error)) {
+    NSLog(@"%@: %s", path, error.c_str());
+    return NO;
+  } return YES;
 }
 
-- (BOOL) facesIteratorEnded {
-  return cppLinkWrapper->cppLink->currentFace == cppLinkWrapper->cppLink->faces.end();
+- (BOOL) writeGeometryFile: (NSString *)path {
+  return cppLinkWrapper->cppLink->writeGeometryFile([path UTF8String]) ? YES : NO;
 }
 
-- (const float *)currentFaceColour {
-  return cppLinkWrapper->cppLink->currentFace->colour;
+- (long) numberOfFaceVertices {
+  return cppLinkWrapper->cppLink->numberOfFaceVertices();
 }
 
-- (void) initialiseFaceTrianglesIterator {
-  cppLinkWrapper->cppLink->currentFaceTriangle = cppLinkWrapper->cppLink->currentFace->triangles.begin();
+- (void) copyFaceVertices: (void *)destination {
+  cppLinkWrapper->cppLink->copyFaceVertices(static_cast<Vertex4 *>(destination));
 }
 
-- (void) advanceFaceTrianglesIterator {
-  ++cppLinkWrapper->cppLink->currentFaceTriangle;
+- (long) numberOfEdges {
+  return cppLinkWrapper->cppLink->numberOfEdges();
 }
 
-- (BOOL) faceTrianglesIteratorEnded {
-  return cppLinkWrapper->cppLink->currentFaceTriangle == cppLinkWrapper->cppLink->currentFace->triangles.end();
+- (void) copyEdgeVertexCounts: (unsigned int *)destination {
+  cppLinkWrapper->cppLink->copyEdgeVertexCounts(destination);
 }
 
-- (const float *)currentFaceTriangleVertex: (long)index {
-  for (unsigned int i = 0; i < 4; ++i) {
-    cppLinkWrapper->cppLink->currentPointCoordinates[i] = cppLinkWrapper->cppLink->currentFaceTriangle->vertices[index].cartesian(i);
-  } return cppLinkWrapper->cppLink->currentPointCoordinates; 
+- (long) numberOfEdgeVertices {
+  return cppLinkWrapper->cppLink->numberOfEdgeVertices();
 }
 
-- (void) initialiseEdgesIterator {
-  cppLinkWrapper->cppLink->currentEdge = cppLinkWrapper->cppLink->edges.begin();
+- (void) copyEdgeVertices: (void *)destination {
+  cppLinkWrapper->cppLink->copyEdgeVertices(static_cast<Vertex4 *>(destination));
 }
 
-- (void) advanceEdgesIterator {
-  ++cppLinkWrapper->cppLink->currentEdge;
+- (long) numberOfEdgeSegmentIndices {
+  return cppLinkWrapper->cppLink->numberOfEdgeSegmentIndices();
 }
 
-- (BOOL) edgesIteratorEnded {
-  return cppLinkWrapper->cppLink->currentEdge == cppLinkWrapper->cppLink->edges.end();
+- (void) copyEdgeVertexSegmentIndices: (unsigned int *)destination first: (unsigned int)first {
+  cppLinkWrapper->cppLink->copyEdgeVertexSegmentIndices(destination, first);
 }
 
-- (void) initialiseEdgeVerticesIterator {
-  cppLinkWrapper->cppLink->currentEdgeVertex = cppLinkWrapper->cppLink->currentEdge->vertices.begin();
+- (long) numberOfVertices {
+  return cppLinkWrapper->cppLink->numberOfVertices();
 }
 
-- (BOOL) edgeVerticesIteratorEnded {
-  return cppLinkWrapper->cppLink->currentEdgeVertex == cppLinkWrapper->cppLink->currentEdge->vertices.end();
+- (void) copyVertices: (void *)destination {
+  cppLinkWrapper->cppLink->copyVertices(static_cast<Vertex4 *>(destination));
 }
 
-- (void) advanceEdgeVerticesIterator {
-  ++cppLinkWrapper->cppLink->currentEdgeVertex;
+- (void) rotateFrom: (int)first to: (int)second angle: (double)angle {
+  cppLinkWrapper->rotation.rotate(first, second, angle);
 }
 
-- (const float *)currentEdgeVertex {
-  for (unsigned int i = 0; i < 4; ++i) {
-    cppLinkWrapper->cppLink->currentPointCoordinates[i] = cppLinkWrapper->cppLink->currentEdgeVertex->cartesian(i);
-  } return cppLinkWrapper->cppLink->currentPointCoordinates;
+- (void) resetRotation {
+  cppLinkWrapper->rotation.reset();
 }
 
-- (void) initialiseVerticesIterator {
-  cppLinkWrapper->cppLink->currentVertex = cppLinkWrapper->cppLink->vertices.begin();
-}
-
-- (void) advanceVerticesIterator {
-  ++cppLinkWrapper->cppLink->currentVertex;
-}
-
-- (BOOL) verticesIteratorEnded {
-  return cppLinkWrapper->cppLink->currentVertex == cppLinkWrapper->cppLink->vertices.end();
-}
-
-- (const float *)currentVertex {
-  for (unsigned int i = 0; i < 4; ++i) {
-    cppLinkWrapper->cppLink->currentPointCoordinates[i] = cppLinkWrapper->cppLink->currentVertex->cartesian(i);
-  } return cppLinkWrapper->cppLink->currentPointCoordinates;
+- (void) copyTransformationMatrix: (void *)destination {
+  *static_cast<Matrix4 *>(destination) = cppLinkWrapper->rotation.matrix();
 }
 
 - (void) dealloc {
@@ -0,0 +1,389 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Export.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "HashTables.hpp"
+
+bool writeOff4(const std::string &path, const Model_d &model) {
+  std::ofstream file(path);
+  if (!file) return false;
+  
+  PointIndex vertices;
+  std::vector<std::uint32_t> faceVertices;
+  for (auto const &polygon : model.polygons) {
+    for (auto const &vertex : polygon.vertices) faceVertices.push_back(vertices.insert(vertex));
+  }
+  
+  file << "4OFF\n";
+  file << vertices.size() << " " << model.polygons.size() << " " << model.materials.size() << "\n";
+  file.precision(std::numeric_limits<float>::max_digits10);
+  for (auto const &material : model.materials) {
+    file << material[0] << " " << material[1] << " " << material[2] << " " << material[3] << "\n";
+  } file.precision(std::numeric_limits<double>::max_digits10);
+  for (auto const &vertex : vertices.points) {
+    file << vertex[0] << " " << vertex[1] << " " << vertex[2] << " " << vertex[3] << "\n";
+  } std::size_t faceVertex = 0;
+  for (std::size_t polygon = 0; polygon < model.polygons.size(); ++polygon) {
+    file << model.polygons[polygon].vertices.size();
+    for (std::size_t vertex = 0; vertex < model.polygons[polygon].vertices.size(); ++vertex) file << " " << faceVertices[faceVertex++];
+    file << " " << model.materialOfFace[polygon] << "\n";
+  }
+  
+  return bool(file);
+}
+
+bool exportFormatFromPath(const std::string &path, ExportFormat &format) {
+  std::size_t dot = path.rfind('.');
+  std::string extension = (dot == std::string::npos) ? "" : path.substr(dot+1);
+  if (extension == "obj") format = ExportFormat::obj;
+  else if (extension == "ply") format = ExportFormat::ply;
+  else if (extension == "glb") format = ExportFormat::glb;
+  else return false;
+  return true;
+}
+
+static bool littleEndian() {
+  std::uint32_t one = 1;
+  unsigned char firstByte;
+  memcpy(&firstByte, &one, 1);
+  return firstByte == 1;
+}
+
+// Collects small binary records and writes them to file in large blocks
+class BlockWriter {
+public:
+  explicit BlockWriter(std::ofstream &file) : file(file) {
+    block.reserve(blockSize);
+  }
+  
+  ~BlockWriter() {
+    flush();
+  }
+  
+  template <class T>
+  void put(const T &value) {
+    const char *bytes = reinterpret_cast<const char *>(&value);
+    block.insert(block.end(), bytes, bytes+sizeof(T));
+    if (block.size() >= blockSize) flush();
+  }
+  
+  void flush() {
+    file.write(block.data(), block.size());
+    block.clear();
+  }
+  
+private:
+  static const std::size_t blockSize = 1 << 20;
+  std::ofstream &file;
+  std::vector<char> block;
+};
+
+// Calls fill(first, count, vertices) to set up vertices first to
+// first+count-1 of all, at most chunkSize at a time, projects them and
+// passes them to write(vertices, count)
+template <class Fill, class Write>
+static void forEachProjectedChunk(std::size_t count, std::size_t chunkSize, Projection projection, const ProjectionParameters &projectionParameters, Fill fill, Write write) {
+  std::vector<Vertex4> chunk(std::min(count, chunkSize));
+  for (std::size_t first = 0; first < count; first += chunkSize) {
+    std::size_t size = std::min(chunkSize, count-first);
+    fill(first, size, chunk.data());
+    project(projection, chunk.data(), chunk.data(), size, projectionParameters);
+    write(chunk.data(), size);
+  }
+}
+
+static void fillPositions(const GeometryView &geometry, std::size_t first, std::size_t count, Vertex4 *vertices) {
+  for (std::size_t vertex = 0; vertex < count; ++vertex) {
+    vertices[vertex].position = geometry.vertices[first+vertex];
+    vertices[vertex].colour = Float4(0.0f, 0.0f, 0.0f, 0.0f);
+  }
+}
+
+// Points can project to infinity, e.g. from the pole of a stereographic
+// projection. Every format leaves out the triangles with such a corner and the
+// edge segments with such an end, but still writes the points themselves so
+// that indices do not change, with their non-finite coordinates as 0.
+static float finitePosition(float coordinate) {
+  return std::isfinite(coordinate) ? coordinate : 0.0f;
+}
+
+// Whether each position of geometry projects to a finite point, also passing
+// the projected positions to visit(vertices, count)
+template <class Visit>
+static std::vector<bool> finiteProjections(const GeometryView &geometry, Projection projection, const ProjectionParameters &projectionParameters, std::size_t verticesPerChunk, Visit visit) {
+  std::vector<bool> finite(geometry.vertices.size());
+  std::size_t next = 0;
+  forEachProjectedChunk(geometry.vertices.size(), verticesPerChunk, projection, projectionParameters, [&](std::size_t first, std::size_t count, Vertex4 *vertices) {
+    fillPositions(geometry, first, count, vertices);
+  }, [&](const Vertex4 *vertices, std::size_t count) {
+    for (std::size_t vertex = 0; vertex < count; ++vertex) {
+      const Float4 &position = vertices[vertex].position;
+      finite[next++] = std::isfinite(position[0]) && std::isfinite(position[1]) && std::isfinite(position[2]);
+    } visit(vertices, count);
+  });
+  return finite;
+}
+
+static bool finiteTriangle(const GeometryView &geometry, const std::vector<bool> &finite, std::uint32_t firstTriangleVertex) {
+  return finite[geometry.triangles[firstTriangleVertex]] && finite[geometry.triangles[firstTriangleVertex+1]] && finite[geometry.triangles[firstTriangleVertex+2]];
+}
+
+// Segment from edge vertex edgeVertex-1 to edgeVertex
+static bool finiteSegment(const GeometryView &geometry, const std::vector<bool> &finite, std::uint32_t edgeVertex) {
+  return finite[geometry.edgeVertices[edgeVertex-1]] && finite[geometry.edgeVertices[edgeVertex]];
+}
+
+static std::uint8_t colourByte(float component) {
+  return std::uint8_t(std::lround(std::min(std::max(component, 0.0f), 1.0f)*255.0f));
+}
+
+static bool writeProjectedObj(std::ofstream &file, const GeometryView &geometry, const Float4 &edgeColour,
+                              Projection projection, const ProjectionParameters &projectionParameters, std::size_t verticesPerChunk) {
+  std::vector<bool> finite = finiteProjections(geometry, projection, projectionParameters, verticesPerChunk, [](const Vertex4 *, std::size_t) {});
+  auto writeVertices = [&](const Vertex4 *vertices, std::size_t count) {
+    for (std::size_t vertex = 0; vertex < count; ++vertex) {
+      file << "v " << finitePosition(vertices[vertex].position[0]) << " " << finitePosition(vertices[vertex].position[1]) << " " << finitePosition(vertices[vertex].position[2]) << " " << vertices[vertex].colour[0] << " " << vertices[vertex].colour[1] << " " << vertices[vertex].colour[2] << "\n";
+    }
+  };
+  
+  // One vertex per use, coloured like its face or edge
+  forEachProjectedChunk(geometry.triangles.size(), verticesPerChunk, projection, projectionParameters, [&](std::size_t first, std::size_t count, Vertex4 *vertices) {
+    std::size_t face = std::upper_bound(geometry.faceOffsets.begin(), geometry.faceOffsets.end(), std::uint32_t(first))-geometry.faceOffsets.begin()-1;
+    for (std::size_t vertex = 0; vertex < count; ++vertex) {
+      while (geometry.faceOffsets[face+1] <= first+vertex) ++face;
+      vertices[vertex].position = geometry.vertices[geometry.triangles[first+vertex]];
+      vertices[vertex].colour = geometry.materialColours[geometry.faceMaterials[face]];
+    }
+  }, writeVertices);
+  forEachProjectedChunk(geometry.edgeVertices.size(), verticesPerChunk, projection, projectionParameters, [&](std::size_t first, std::size_t count, Vertex4 *vertices) {
+    for (std::size_t vertex = 0; vertex < count; ++vertex) {
+      vertices[vertex].position = geometry.vertices[geometry.edgeVertices[first+vertex]];
+      vertices[vertex].colour = edgeColour;
+    }
+  }, writeVertices);
+  
+  // OBJ indices start at 1. Edges are split into polylines where they reach a
+  // point that does not project to a finite one.
+  for (std::size_t triangle = 0; triangle < geometry.numberOfTriangles(); ++triangle) {
+    if (finiteTriangle(geometry, finite, std::uint32_t(3*triangle))) file << "f " << 3*triangle+1 << " " << 3*triangle+2 << " " << 3*triangle+3 << "\n";
+  } std::size_t index = geometry.triangles.size()+1;
+  for (std::size_t edge = 0; edge < geometry.numberOfEdges(); ++edge) {
+    bool inPolyline = false;
+    for (std::uint32_t vertex = geometry.edgeOffsets[edge]+1; vertex < geometry.edgeOffsets[edge+1]; ++vertex, ++index) {
+      if (!finiteSegment(geometry, finite, vertex)) {
+        if (inPolyline) file << "\n";
+        inPolyline = false;
+        continue;
+      } if (!inPolyline) file << "l " << index;
+      file << " " << index+1;
+      inPolyline = true;
+    } if (inPolyline) file << "\n";
+    ++index;
+  } return bool(file);
+}
+
+// The header holds the numbers of triangles and edge segments that are left
+// after leaving out the non-finite ones, so positions are projected twice
+static bool writeProjectedPly(std::ofstream &file, const GeometryView &geometry, const Float4 &edgeColour,
+                              Projection projection, const ProjectionParameters &projectionParameters, std::size_t verticesPerChunk) {
+  std::vector<bool> finite = finiteProjections(geometry, projection, projectionParameters, verticesPerChunk, [](const Vertex4 *, std::size_t) {});
+  std::size_t numberOfTriangles = 0, numberOfSegments = 0;
+  for (std::uint32_t triangleVertex = 0; triangleVertex < geometry.triangles.size(); triangleVertex += 3) {
+    if (finiteTriangle(geometry, finite, triangleVertex)) ++numberOfTriangles;
+  } for (std::size_t edge = 0; edge < geometry.numberOfEdges(); ++edge) {
+    for (std::uint32_t edgeVertex = geometry.edgeOffsets[edge]+1; edgeVertex < geometry.edgeOffsets[edge+1]; ++edgeVertex) {
+      if (finiteSegment(geometry, finite, edgeVertex)) ++numberOfSegments;
+    }
+  }
+  
+  file << "ply\n";
+  file << "format " << (littleEndian() ? "binary_little_endian" : "binary_big_endian") << " 1.0\n";
+  file << "element vertex " << geometry.vertices.size() << "\n";
+  file << "property float x\nproperty float y\nproperty float z\n";
+  file << "element face " << numberOfTriangles << "\n";
+  file << "property list uchar uint vertex_indices\n";
+  file << "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty uchar alpha\n";
+  file << "element edge " << numberOfSegments << "\n";
+  file << "property uint vertex1\nproperty uint vertex2\n";
+  file << "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty uchar alpha\n";
+  file << "end_header\n";
+  
+  BlockWriter writer(file);
+  forEachProjectedChunk(geometry.vertices.size(), verticesPerChunk, projection, projectionParameters, [&](std::size_t first, std::size_t count, Vertex4 *vertices) {
+    fillPositions(geometry, first, count, vertices);
+  }, [&](const Vertex4 *vertices, std::size_t count) {
+    for (std::size_t vertex = 0; vertex < count; ++vertex) {
+      for (unsigned int coordinate = 0; coordinate < 3; ++coordinate) writer.put(finitePosition(vertices[vertex].position[coordinate]));
+    }
+  });
+  
+  for (std::size_t face = 0; face < geometry.numberOfFaces(); ++face) {
+    const Float4 &colour = geometry.materialColours[geometry.faceMaterials[face]];
+    for (std::uint32_t triangleVertex = geometry.faceOffsets[face]; triangleVertex < geometry.faceOffsets[face+1]; triangleVertex += 3) {
+      if (!finiteTriangle(geometry, finite, triangleVertex)) continue;
+      writer.put(std::uint8_t(3));
+      for (std::uint32_t vertex = 0; vertex < 3; ++vertex) writer.put(geometry.triangles[triangleVertex+vertex]);
+      for (unsigned int component = 0; component < 4; ++component) writer.put(colourByte(colour[component]));
+    }
+  } for (std::size_t edge = 0; edge < geometry.numberOfEdges(); ++edge) {
+    for (std::uint32_t edgeVertex = geometry.edgeOffsets[edge]+1; edgeVertex < geometry.edgeOffsets[edge+1]; ++edgeVertex) {
+      if (!finiteSegment(geometry, finite, edgeVertex)) continue;
+      writer.put(geometry.edgeVertices[edgeVertex-1]);
+      writer.put(geometry.edgeVertices[edgeVertex]);
+      for (unsigned int component = 0; component < 4; ++component) writer.put(colourByte(edgeColour[component]));
+    }
+  }
+  
+  writer.flush();
+  return bool(file);
+}
+
+// glTF requires the bounds of the positions and the numbers of indices in
+// advance, so positions are projected twice: once for those and once to
+// write them. A model with nothing to draw is an empty scene without buffers.
+static bool writeProjectedGlb(std::ofstream &file, const GeometryView &geometry, const Float4 &edgeColour,
+                              Projection projection, const ProjectionParameters &projectionParameters, std::size_t verticesPerChunk) {
+  if (!littleEndian()) return false;
+  
+  float minimum[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+  float maximum[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+  std::vector<bool> finite = finiteProjections(geometry, projection, projectionParameters, verticesPerChunk, [&](const Vertex4 *vertices, std::size_t count) {
+    for (std::size_t vertex = 0; vertex < count; ++vertex) {
+      for (unsigned int coordinate = 0; coordinate < 3; ++coordinate) {
+        float value = finitePosition(vertices[vertex].position[coordinate]);
+        minimum[coordinate] = std::min(minimum[coordinate], value);
+        maximum[coordinate] = std::max(maximum[coordinate], value);
+      }
+    }
+  });
+  
+  // Layout of the binary chunk: the positions, then the triangle indices of
+  // each material in turn, then the edge segment indices
+  std::vector<std::size_t> materialIndices(geometry.materialColours.size(), 0);
+  std::vector<std::size_t> materialFaceOffsets(geometry.materialColours.size()+1, 0);
+  for (std::size_t face = 0; face < geometry.numberOfFaces(); ++face) {
+    for (std::uint32_t triangleVertex = geometry.faceOffsets[face]; triangleVertex < geometry.faceOffsets[face+1]; triangleVertex += 3) {
+      if (finiteTriangle(geometry, finite, triangleVertex)) materialIndices[geometry.faceMaterials[face]] += 3;
+    } ++materialFaceOffsets[geometry.faceMaterials[face]+1];
+  }
+  
+  // Faces bucketed by material in their original order, so that every
+  // material's indices are written without going through all faces again
+  for (std::size_t material = 0; material < materialIndices.size(); ++material) materialFaceOffsets[material+1] += materialFaceOffsets[material];
+  std::vector<std::uint32_t> facesByMaterial(geometry.numberOfFaces());
+  std::vector<std::size_t> nextFaceOfMaterial(materialFaceOffsets.begin(), materialFaceOffsets.end()-1);
+  for (std::size_t face = 0; face < geometry.numberOfFaces(); ++face) facesByMaterial[nextFaceOfMaterial[geometry.faceMaterials[face]]++] = std::uint32_t(face);
+  std::size_t edgeIndices = 0;
+  for (std::size_t edge = 0; edge < geometry.numberOfEdges(); ++edge) {
+    for (std::uint32_t edgeVertex = geometry.edgeOffsets[edge]+1; edgeVertex < geometry.edgeOffsets[edge+1]; ++edgeVertex) {
+      if (finiteSegment(geometry, finite, edgeVertex)) edgeIndices += 2;
+    }
+  }
+  std::size_t binaryLength = 12*geometry.vertices.size();
+  for (auto const &indices : materialIndices) binaryLength += 4*indices;
+  binaryLength += 4*edgeIndices;
+  
+  std::ostringstream json;
+  json.precision(std::numeric_limits<float>::max_digits10);
+  std::ostringstream primitives, materials, bufferViews, accessors;
+  primitives.precision(json.precision());
+  materials.precision(json.precision());
+  accessors.precision(json.precision());
+  bufferViews << "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" << 12*geometry.vertices.size() << ",\"target\":34962}";
+  accessors << "{\"bufferView\":0,\"componentType\":5126,\"count\":" << geometry.vertices.size() << ",\"type\":\"VEC3\",\"min\":[" << minimum[0] << "," << minimum[1] << "," << minimum[2] << "],\"max\":[" << maximum[0] << "," << maximum[1] << "," << maximum[2] << "]}";
+  std::size_t offset = 12*geometry.vertices.size(), numberOfPrimitives = 0;
+  auto addPrimitive = [&](std::size_t indices, const Float4 &colour, unsigned int mode) {
+    std::size_t material = numberOfPrimitives++;
+    bufferViews << ",{\"buffer\":0,\"byteOffset\":" << offset << ",\"byteLength\":" << 4*indices << ",\"target\":34963}";
+    accessors << ",{\"bufferView\":" << material+1 << ",\"componentType\":5125,\"count\":" << indices << ",\"type\":\"SCALAR\"}";
+    primitives << (material == 0 ? "" : ",") << "{\"attributes\":{\"POSITION\":0},\"indices\":" << material+1 << ",\"material\":" << material << ",\"mode\":" << mode << "}";
+    materials << (material == 0 ? "" : ",") << "{\"pbrMetallicRoughness\":{\"baseColorFactor\":[" << colour[0] << "," << colour[1] << "," << colour[2] << "," << colour[3] << "],\"metallicFactor\":0,\"roughnessFactor\":1},\"alphaMode\":\"BLEND\",\"doubleSided\":true}";
+    offset += 4*indices;
+  };
+  for (std::size_t material = 0; material < materialIndices.size(); ++material) {
+    if (materialIndices[material] > 0) addPrimitive(materialIndices[material], geometry.materialColours[material], 4);
+  } if (edgeIndices > 0) addPrimitive(edgeIndices, edgeColour, 1);
+  json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"azul4d\"},\"scene\":0,";
+  if (numberOfPrimitives == 0) json << "\"scenes\":[{\"nodes\":[]}]}";
+  else {
+    json << "\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],\"meshes\":[{\"primitives\":[" << primitives.str() << "]}],\"materials\":[" << materials.str() << "],";
+    json << "\"buffers\":[{\"byteLength\":" << binaryLength << "}],\"bufferViews\":[" << bufferViews.str() << "],\"accessors\":[" << accessors.str() << "]}";
+  } std::string jsonChunk = json.str();
+  jsonChunk.append((4-jsonChunk.size()%4)%4, ' ');
+  std::size_t binaryChunkLength = numberOfPrimitives == 0 ? 0 : 8+binaryLength;
+  if (12+8+jsonChunk.size()+binaryChunkLength > std::numeric_limits<std::uint32_t>::max()) return false;
+  
+  BlockWriter writer(file);
+  writer.put(std::uint32_t(0x46546c67)); // glTF
+  writer.put(std::uint32_t(2));
+  writer.put(std::uint32_t(12+8+jsonChunk.size()+binaryChunkLength));
+  writer.put(std::uint32_t(jsonChunk.size()));
+  writer.put(std::uint32_t(0x4e4f534a)); // JSON
+  for (auto const &character : jsonChunk) writer.put(character);
+  if (numberOfPrimitives == 0) {
+    writer.flush();
+    return bool(file);
+  } writer.put(std::uint32_t(binaryLength));
+  writer.put(std::uint32_t(0x004e4942)); // BIN
+  
+  forEachProjectedChunk(geometry.vertices.size(), verticesPerChunk, projection, projectionParameters, [&](std::size_t first, std::size_t count, Vertex4 *vertices) {
+    fillPositions(geometry, first, count, vertices);
+  }, [&](const Vertex4 *vertices, std::size_t count) {
+    for (std::size_t vertex = 0; vertex < count; ++vertex) {
+      for (unsigned int coordinate = 0; coordinate < 3; ++coordinate) writer.put(finitePosition(vertices[vertex].position[coordinate]));
+    }
+  });
+  for (std::size_t material = 0; material < materialIndices.size(); ++material) {
+    for (std::size_t materialFace = materialFaceOffsets[material]; materialFace < materialFaceOffsets[material+1]; ++materialFace) {
+      std::uint32_t face = facesByMaterial[materialFace];
+      for (std::uint32_t triangleVertex = geometry.faceOffsets[face]; triangleVertex < geometry.faceOffsets[face+1]; triangleVertex += 3) {
+        if (!finiteTriangle(geometry, finite, triangleVertex)) continue;
+        for (std::uint32_t vertex = 0; vertex < 3; ++vertex) writer.put(geometry.triangles[triangleVertex+vertex]);
+      }
+    }
+  } for (std::size_t edge = 0; edge < geometry.numberOfEdges(); ++edge) {
+    for (std::uint32_t edgeVertex = geometry.edgeOffsets[edge]+1; edgeVertex < geometry.edgeOffsets[edge+1]; ++edgeVertex) {
+      if (!finiteSegment(geometry, finite, edgeVertex)) continue;
+      writer.put(geometry.edgeVertices[edgeVertex-1]);
+      writer.put(geometry.edgeVertices[edgeVertex]);
+    }
+  }
+  
+  writer.flush();
+  return bool(file);
+}
+
+bool exportProjected(const std::string &path, ExportFormat format, const GeometryView &geometry, const Float4 &edgeColour,
+                     Projection projection, const ProjectionParameters &projectionParameters, std::size_t verticesPerChunk) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file || verticesPerChunk == 0) return false;
+  switch (format) {
+    case ExportFormat::obj:
+      return writeProjectedObj(file, geometry, edgeColour, projection, projectionParameters, verticesPerChunk);
+    case ExportFormat::ply:
+      return writeProjectedPly(file, geometry, edgeColour, projection, projectionParameters, verticesPerChunk);
+    case ExportFormat::glb:
+      return writeProjectedGlb(file, geometry, edgeColour, projection, projectionParameters, verticesPerChunk);
+  } return false;
+}
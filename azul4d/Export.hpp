@@ -0,0 +1,58 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef Export_hpp
+#define Export_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Geometry4.hpp"
+#include "GeometryView.hpp"
+#include "Model.hpp"
+#include "Projection.hpp"
+
+// Writes a model in the 4OFF format read by ModelReader, storing each
+// distinct vertex once. Returns false on I/O errors.
+bool writeOff4(const std::string &path, const Model_d &model);
+
+enum class ExportFormat {
+  obj,
+  ply,
+  glb
+};
+
+// Picks the format from the extension of path: .obj, .ply or .glb
+bool exportFormatFromPath(const std::string &path, ExportFormat &format);
+
+// Projects geometry and writes it, projecting and writing at most
+// verticesPerChunk vertices at a time so that the projected result is never
+// held in memory as a whole:
+// - obj is Wavefront OBJ with one vertex per triangle corner and edge
+//   vertex, coloured like its face or with edgeColour, every three face
+//   vertices forming a triangle and every edge a polyline
+// - ply is binary with every position once, triangles with their face
+//   colour and edge segments with edgeColour
+// - glb is binary glTF with every position once, one primitive per material
+//   and a line primitive for the edges, or an empty scene if there is
+//   nothing to draw
+// Triangles with a corner and edge segments with an end that project to
+// infinity are left out of all formats. Returns false on I/O errors.
+bool exportProjected(const std::string &path, ExportFormat format, const GeometryView &geometry, const Float4 &edgeColour,
+                     Projection projection, const ProjectionParameters &projectionParameters, std::size_t verticesPerChunk = 65536);
+
+#endif /* Export_hpp */
@@ -0,0 +1,132 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef Geometry4_hpp
+#define Geometry4_hpp
+
+#include <cmath>
+#include <type_traits>
+
+// Fixed-dimension 4D types. They live on the stack and are trivially copyable,
+// so they can be stored in contiguous arrays and copied with memcpy.
+
+struct Vector4 {
+  double coordinates[4];
+
+  Vector4() = default;
+  Vector4(double x, double y, double z, double w) : coordinates{x, y, z, w} {}
+
+  double operator[](unsigned int i) const { return coordinates[i]; }
+  double &operator[](unsigned int i) { return coordinates[i]; }
+  double cartesian(unsigned int i) const { return coordinates[i]; }
+
+  double squared_length() const {
+    return coordinates[0]*coordinates[0]+coordinates[1]*coordinates[1]+coordinates[2]*coordinates[2]+coordinates[3]*coordinates[3];
+  }
+
+  Vector4 &operator*=(double s) {
+    for (unsigned int i = 0; i < 4; ++i) coordinates[i] *= s;
+    return *this;
+  }
+
+  Vector4 &operator/=(double s) {
+    for (unsigned int i = 0; i < 4; ++i) coordinates[i] /= s;
+    return *this;
+  }
+};
+
+struct Point4 {
+  double coordinates[4];
+
+  Point4() = default;
+  Point4(double x, double y, double z, double w) : coordinates{x, y, z, w} {}
+  explicit Point4(const double *c) : coordinates{c[0], c[1], c[2], c[3]} {}
+
+  double operator[](unsigned int i) const { return coordinates[i]; }
+  double &operator[](unsigned int i) { return coordinates[i]; }
+  double cartesian(unsigned int i) const { return coordinates[i]; }
+};
+
+static_assert(std::is_trivially_copyable<Vector4>::value, "Vector4 must be trivially copyable");
+static_assert(std::is_trivially_copyable<Point4>::value, "Point4 must be trivially copyable");
+static_assert(sizeof(Point4) == 4*sizeof(double), "Point4 must be tightly packed");
+
+inline Vector4 operator-(const Point4 &p, const Point4 &q) {
+  return Vector4(p[0]-q[0], p[1]-q[1], p[2]-q[2], p[3]-q[3]);
+}
+
+inline Point4 operator+(const Point4 &p, const Vector4 &v) {
+  return Point4(p[0]+v[0], p[1]+v[1], p[2]+v[2], p[3]+v[3]);
+}
+
+inline Vector4 operator+(const Vector4 &u, const Vector4 &v) {
+  return Vector4(u[0]+v[0], u[1]+v[1], u[2]+v[2], u[3]+v[3]);
+}
+
+inline Vector4 operator-(const Vector4 &u, const Vector4 &v) {
+  return Vector4(u[0]-v[0], u[1]-v[1], u[2]-v[2], u[3]-v[3]);
+}
+
+inline Vector4 operator*(double s, const Vector4 &v) {
+  return Vector4(s*v[0], s*v[1], s*v[2], s*v[3]);
+}
+
+// Dot product, as in CGAL::Vector_d
+inline double operator*(const Vector4 &u, const Vector4 &v) {
+  return u[0]*v[0]+u[1]*v[1]+u[2]*v[2]+u[3]*v[3];
+}
+
+inline bool operator==(const Point4 &p, const Point4 &q) {
+  return p[0] == q[0] && p[1] == q[1] && p[2] == q[2] && p[3] == q[3];
+}
+
+inline bool operator!=(const Point4 &p, const Point4 &q) {
+  return !(p == q);
+}
+
+// Lexicographic order, as in CGAL::Point_d
+inline bool operator<(const Point4 &p, const Point4 &q) {
+  for (unsigned int i = 0; i < 4; ++i) {
+    if (p[i] < q[i]) return true;
+    if (q[i] < p[i]) return false;
+  } return false;
+}
+
+// Single-precision 4D vector with the same size and alignment as float4 in
+// Metal, used for positions and colours that are handed to a renderer
+struct alignas(16) Float4 {
+  float coordinates[4];
+
+  Float4() = default;
+  Float4(float x, float y, float z, float w) : coordinates{x, y, z, w} {}
+  explicit Float4(const Point4 &point) : coordinates{float(point[0]), float(point[1]), float(point[2]), float(point[3])} {}
+
+  float operator[](unsigned int i) const { return coordinates[i]; }
+  float &operator[](unsigned int i) { return coordinates[i]; }
+};
+
+static_assert(std::is_trivially_copyable<Float4>::value, "Float4 must be trivially copyable");
+static_assert(sizeof(Float4) == 16, "Float4 must match the layout of float4");
+
+// Interleaved vertex with the same layout as Vertex in MetalView.swift
+struct Vertex4 {
+  Float4 position;
+  Float4 colour;
+};
+
+static_assert(sizeof(Vertex4) == 32, "Vertex4 must match the layout of Vertex");
+
+#endif /* Geometry4_hpp */
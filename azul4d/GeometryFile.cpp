@@ -0,0 +1,182 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "GeometryFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char fileMagic[4] = {'A', '4', 'D', 'G'};
+static const std::size_t numberOfSections = 8;
+static const std::size_t sectionAlignment = 64;
+
+struct Section {
+  std::uint64_t offset;
+  std::uint64_t count;
+};
+
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  Section sections[numberOfSections];
+};
+
+static bool littleEndian() {
+  std::uint32_t one = 1;
+  unsigned char firstByte;
+  memcpy(&firstByte, &one, 1);
+  return firstByte == 1;
+}
+
+static std::uint64_t aligned(std::uint64_t offset) {
+  return (offset+sectionAlignment-1)/sectionAlignment*sectionAlignment;
+}
+
+template <class T>
+static void writeSection(std::ofstream &file, Header &header, std::size_t section, const ArrayView<T> &values) {
+  static const char padding[sectionAlignment] = {};
+  std::uint64_t position = std::uint64_t(file.tellp());
+  file.write(padding, aligned(position)-position);
+  header.sections[section] = Section{aligned(position), values.size()};
+  file.write(reinterpret_cast<const char *>(values.data()), values.size()*sizeof(T));
+}
+
+bool GeometryFile::write(const std::string &path, const GeometryView &geometry) {
+  if (!littleEndian()) return false;
+  
+  // Written under a temporary name and renamed, so that readers never see a partial file
+  std::string temporaryPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream file(temporaryPath, std::ios::binary);
+    if (!file) return false;
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, fileMagic, 4);
+    header.version = version;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    writeSection(file, header, 0, geometry.vertices);
+    writeSection(file, header, 1, geometry.triangles);
+    writeSection(file, header, 2, geometry.faceOffsets);
+    writeSection(file, header, 3, geometry.faceMaterials);
+    writeSection(file, header, 4, geometry.materialColours);
+    writeSection(file, header, 5, geometry.edgeVertices);
+    writeSection(file, header, 6, geometry.edgeOffsets);
+    writeSection(file, header, 7, geometry.corners);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    if (!file) {
+      file.close();
+      std::remove(temporaryPath.c_str());
+      return false;
+    }
+  } if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    std::remove(temporaryPath.c_str());
+    return false;
+  } return true;
+}
+
+GeometryFile::~GeometryFile() {
+  close();
+}
+
+void GeometryFile::close() {
+  if (mapping != nullptr) munmap(mapping, length);
+  mapping = nullptr;
+  length = 0;
+  geometry = GeometryView();
+}
+
+bool GeometryFile::fail(const std::string &message) {
+  close();
+  error = message;
+  return false;
+}
+
+// Points view at a section after checking that it lies within the file
+template <class T>
+static bool mapSection(const char *base, std::size_t length, const Section &section, ArrayView<T> &view) {
+  if (section.offset % sectionAlignment != 0 || section.offset > length) return false;
+  if (section.count > (length-section.offset)/sizeof(T)) return false;
+  view = ArrayView<T>(reinterpret_cast<const T *>(base+section.offset), section.count);
+  return true;
+}
+
+// Whether offsets split all values into numberOfRanges consecutive ranges,
+// which are not empty unless allowEmpty and all start at a multiple of
+// multipleOf, so that e.g. face ranges only hold whole triangles
+static bool validOffsets(const ArrayView<std::uint32_t> &offsets, std::size_t numberOfRanges, std::size_t numberOfValues, bool allowEmpty, std::size_t multipleOf) {
+  if (offsets.empty()) return numberOfRanges == 0 && numberOfValues == 0;
+  if (offsets.size() != numberOfRanges+1 || offsets[0] != 0 || offsets[numberOfRanges] != numberOfValues) return false;
+  for (std::size_t range = 0; range < numberOfRanges; ++range) {
+    if (offsets[range] > offsets[range+1] || (!allowEmpty && offsets[range] == offsets[range+1]) || offsets[range+1] % multipleOf != 0) return false;
+  } return true;
+}
+
+static bool validIndices(const ArrayView<std::uint32_t> &indices, std::size_t limit) {
+  for (auto const &index : indices) if (index >= limit) return false;
+  return true;
+}
+
+bool GeometryFile::open(const std::string &path) {
+  close();
+  if (!littleEndian()) return fail("geometry files can only be read on little-endian hosts");
+  
+  int descriptor = ::open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) return fail("cannot open "+path);
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || std::size_t(status.st_size) < sizeof(Header)) {
+    ::close(descriptor);
+    return fail("not a geometry file");
+  } length = std::size_t(status.st_size);
+  mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  ::close(descriptor);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    return fail("cannot map "+path);
+  }
+  
+  const char *base = static_cast<const char *>(mapping);
+  Header header;
+  memcpy(&header, base, sizeof(Header));
+  if (memcmp(header.magic, fileMagic, 4) != 0) return fail("not a geometry file");
+  if (header.version != version) return fail("unsupported geometry file version "+std::to_string(header.version));
+  if (!mapSection(base, length, header.sections[0], geometry.vertices) ||
+      !mapSection(base, length, header.sections[1], geometry.triangles) ||
+      !mapSection(base, length, header.sections[2], geometry.faceOffsets) ||
+      !mapSection(base, length, header.sections[3], geometry.faceMaterials) ||
+      !mapSection(base, length, header.sections[4], geometry.materialColours) ||
+      !mapSection(base, length, header.sections[5], geometry.edgeVertices) ||
+      !mapSection(base, length, header.sections[6], geometry.edgeOffsets) ||
+      !mapSection(base, length, header.sections[7], geometry.corners)) return fail("truncated geometry file");
+  
+  // Checked once here so that nothing reads outside the arrays later
+  if (geometry.triangles.size() % 3 != 0 ||
+      !validOffsets(geometry.faceOffsets, geometry.faceMaterials.size(), geometry.triangles.size(), true, 3) ||
+      !validOffsets(geometry.edgeOffsets, geometry.numberOfEdges(), geometry.edgeVertices.size(), false, 1) ||
+      !validIndices(geometry.triangles, geometry.vertices.size()) ||
+      !validIndices(geometry.faceMaterials, geometry.materialColours.size()) ||
+      !validIndices(geometry.edgeVertices, geometry.vertices.size()) ||
+      !validIndices(geometry.corners, geometry.vertices.size())) return fail("inconsistent geometry file");
+  return true;
+}
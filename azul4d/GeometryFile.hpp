@@ -0,0 +1,56 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GeometryFile_hpp
+#define GeometryFile_hpp
+
+#include <cstddef>
+#include <string>
+
+#include "GeometryView.hpp"
+
+// Welded geometry stored as-is on disk, so that it can be mapped into memory
+// and used without parsing or copying. The file is little-endian: a header
+// with the magic "A4DG", the version and the offset and number of elements
+// of each array of GeometryView in order, followed by the arrays, each one
+// starting at a multiple of 64 bytes.
+class GeometryFile {
+public:
+  static const std::uint32_t version = 1;
+  std::string error;
+  
+  GeometryFile() = default;
+  GeometryFile(const GeometryFile &) = delete;
+  GeometryFile &operator=(const GeometryFile &) = delete;
+  ~GeometryFile();
+  
+  static bool write(const std::string &path, const GeometryView &geometry);
+  // Maps a file and checks that its arrays are consistent, returning false
+  // and setting error otherwise. The view stays valid until close().
+  bool open(const std::string &path);
+  void close();
+  const GeometryView &view() const { return geometry; }
+  
+private:
+  void *mapping = nullptr;
+  std::size_t length = 0;
+  GeometryView geometry;
+  
+  bool fail(const std::string &message);
+};
+
+#endif /* GeometryFile_hpp */
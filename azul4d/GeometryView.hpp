@@ -0,0 +1,63 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GeometryView_hpp
+#define GeometryView_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Geometry4.hpp"
+
+// Read-only array stored elsewhere, e.g. in a std::vector or a mapped file
+template <class T>
+struct ArrayView {
+  const T *elements = nullptr;
+  std::size_t count = 0;
+  
+  ArrayView() = default;
+  ArrayView(const T *elements, std::size_t count) : elements(elements), count(count) {}
+  ArrayView(const std::vector<T> &vector) : elements(vector.data()), count(vector.size()) {}
+  
+  const T &operator[](std::size_t index) const { return elements[index]; }
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const T *data() const { return elements; }
+  const T *begin() const { return elements; }
+  const T *end() const { return elements+count; }
+};
+
+// The arrays of a GeometryBuffer wherever they are stored, which is what
+// CppLink serves to the renderer
+struct GeometryView {
+  ArrayView<Float4> vertices;
+  ArrayView<std::uint32_t> triangles;
+  ArrayView<std::uint32_t> faceOffsets;
+  ArrayView<std::uint32_t> faceMaterials;
+  ArrayView<Float4> materialColours;
+  ArrayView<std::uint32_t> edgeVertices;
+  ArrayView<std::uint32_t> edgeOffsets;
+  ArrayView<std::uint32_t> corners;
+  
+  std::size_t numberOfFaces() const { return faceMaterials.size(); }
+  std::size_t numberOfTriangles() const { return triangles.size()/3; }
+  std::size_t numberOfEdges() const { return edgeOffsets.empty() ? 0 : edgeOffsets.size()-1; }
+  std::size_t numberOfEdgeSegments() const { return edgeVertices.size()-numberOfEdges(); }
+};
+
+#endif /* GeometryView_hpp */
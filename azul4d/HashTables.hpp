@@ -0,0 +1,151 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HashTables_hpp
+#define HashTables_hpp
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "Geometry4.hpp"
+
+// Open-addressing hash tables with linear probing, kept at most half full.
+// They store plain integers and points in flat arrays, without a node
+// allocation per element.
+
+inline std::uint64_t mixBits(std::uint64_t bits) {
+  bits ^= bits >> 33;
+  bits *= 0xff51afd7ed558ccdULL;
+  bits ^= bits >> 33;
+  bits *= 0xc4ceb9fe1a85ec53ULL;
+  bits ^= bits >> 33;
+  return bits;
+}
+
+inline std::uint64_t hashPoint4(const Point4 &point) {
+  std::uint64_t hash = 0;
+  for (unsigned int coordinate = 0; coordinate < 4; ++coordinate) {
+    double value = point[coordinate];
+    if (value == 0.0) value = 0.0; // -0.0 and 0.0 compare equal, so they must hash equally too
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    hash = mixBits(hash ^ (bits+0x9e3779b97f4a7c15ULL+(hash << 6)+(hash >> 2)));
+  } return hash;
+}
+
+inline std::size_t hashTableCapacity(std::size_t expectedElements) {
+  std::size_t capacity = 16;
+  while (capacity < 2*expectedElements) capacity *= 2;
+  return capacity;
+}
+
+// Assigns consecutive indices 0, 1, 2... to distinct points. With a positive
+// epsilon, points are compared after snapping them to a grid with that
+// spacing, so near-duplicates that fall in the same grid cell are merged and
+// the first one seen is kept.
+class PointIndex {
+public:
+  std::vector<Point4> points;
+  
+  explicit PointIndex(std::size_t expectedPoints = 0, double epsilon = 0.0) : slots(hashTableCapacity(expectedPoints), empty), epsilon(epsilon) {
+    points.reserve(expectedPoints);
+  }
+  
+  // Index of point, adding it if it has not been seen before
+  std::uint32_t insert(const Point4 &point) {
+    if (2*(points.size()+1) > slots.size()) grow();
+    Point4 key = snap(point);
+    std::size_t mask = slots.size()-1;
+    for (std::size_t slot = hashPoint4(key) & mask; ; slot = (slot+1) & mask) {
+      if (slots[slot] == empty) {
+        slots[slot] = std::uint32_t(points.size());
+        points.push_back(point);
+        return slots[slot];
+      } if (snap(points[slots[slot]]) == key) return slots[slot];
+    }
+  }
+  
+  std::size_t size() const { return points.size(); }
+  
+private:
+  static const std::uint32_t empty = 0xffffffff;
+  std::vector<std::uint32_t> slots;
+  double epsilon;
+  
+  Point4 snap(const Point4 &point) const {
+    if (epsilon <= 0.0) return point;
+    return Point4(std::round(point[0]/epsilon), std::round(point[1]/epsilon), std::round(point[2]/epsilon), std::round(point[3]/epsilon));
+  }
+  
+  void grow() {
+    std::vector<std::uint32_t> newSlots(2*slots.size(), empty);
+    std::size_t mask = newSlots.size()-1;
+    for (std::uint32_t index = 0; index < points.size(); ++index) {
+      std::size_t slot = hashPoint4(snap(points[index])) & mask;
+      while (newSlots[slot] != empty) slot = (slot+1) & mask;
+      newSlots[slot] = index;
+    } slots.swap(newSlots);
+  }
+};
+
+// Set of undirected edges between point indices
+class EdgeSet {
+public:
+  explicit EdgeSet(std::size_t expectedEdges = 0) : slots(hashTableCapacity(expectedEdges), empty), numberOfEdges(0) {}
+  
+  // Edges (a, b) and (b, a) have the same key
+  static std::uint64_t key(std::uint32_t a, std::uint32_t b) {
+    if (b < a) std::swap(a, b);
+    return (std::uint64_t(a) << 32) | b;
+  }
+  
+  // True if the edge was not in the set yet
+  bool insert(std::uint32_t a, std::uint32_t b) {
+    if (2*(numberOfEdges+1) > slots.size()) grow();
+    return insertKey(key(a, b), slots);
+  }
+  
+  std::size_t size() const { return numberOfEdges; }
+  
+private:
+  static const std::uint64_t empty = ~std::uint64_t(0);
+  std::vector<std::uint64_t> slots;
+  std::size_t numberOfEdges;
+  
+  bool insertKey(std::uint64_t edgeKey, std::vector<std::uint64_t> &table) {
+    std::size_t mask = table.size()-1;
+    for (std::size_t slot = mixBits(edgeKey) & mask; ; slot = (slot+1) & mask) {
+      if (table[slot] == edgeKey) return false;
+      if (table[slot] == empty) {
+        table[slot] = edgeKey;
+        ++numberOfEdges;
+        return true;
+      }
+    }
+  }
+  
+  void grow() {
+    std::vector<std::uint64_t> newSlots(2*slots.size(), empty);
+    numberOfEdges = 0;
+    for (auto const &edgeKey : slots) if (edgeKey != empty) insertKey(edgeKey, newSlots);
+    slots.swap(newSlots);
+  }
+};
+
+#endif /* HashTables_hpp */
@@ -67,3 +67,24 @@ func matrix_upper_left_3x3(matrix: matrix_float4x4) -> matrix_float3x3 {
                              vector3(matrix.columns.1.x, matrix.columns.1.y, matrix.columns.1.z),
                              vector3(matrix.columns.2.x, matrix.columns.2.y, matrix.columns.2.z))
 }
+
+func determinant3(_ a: Float, _ b: Float, _ c: Float, _ d: Float, _ e: Float, _ f: Float, _ g: Float, _ h: Float, _ i: Float) -> Float {
+  return a*(e*i-f*h) - b*(d*i-f*g) + c*(d*h-e*g)
+}
+
+func cross4(_ u: float4, _ v: float4, _ w: float4) -> float4 {
+  return float4(determinant3(u.y, u.z, u.w, v.y, v.z, v.w, w.y, w.z, w.w),
+                -determinant3(u.x, u.z, u.w, v.x, v.z, v.w, w.x, w.z, w.w),
+                determinant3(u.x, u.y, u.w, v.x, v.y, v.w, w.x, w.y, w.w),
+                -determinant3(u.x, u.y, u.z, v.x, v.y, v.z, w.x, w.y, w.z))
+}
+
+// Axes of an orthographic 4D camera at from looking at to, as the columns x, z,
+// 2w and y used by orthographicProjection in Shaders.metal
+func matrix4x4_orthographic_basis(from: float4, to: float4, up: float4, over: float4) -> matrix_float4x4 {
+  let d = normalize(to-from)
+  let a = normalize(cross4(up, over, d))
+  let b = normalize(cross4(over, d, a))
+  let c = cross4(d, a, b)*2.0
+  return matrix_from_columns(a, b, c, d)
+}
@@ -23,6 +23,8 @@ struct RenderingConstants {
 
 struct ProjectionParameters {
   var transformationMatrix = matrix_identity_float4x4
+  var viewBasis = matrix_identity_float4x4
+  var viewFrom = float4(0.0, 1.0, 0.0, 0.0)
 }
 
 struct Vertex {
@@ -35,12 +37,39 @@ class MetalView: MTKView {
   var commandQueue: MTLCommandQueue?
   var computePipelineState: MTLComputePipelineState?
   var renderPipelineState: MTLRenderPipelineState?
+  var sphereRenderPipelineState: MTLRenderPipelineState?
   var depthStencilState: MTLDepthStencilState?
   
   var eye = float3(0.0, 0.0, 0.0)
   var centre = float3(0.0, 0.0, 5.0)
   var fieldOfView: Float = 1.047197551196598
   
+  // Changing any of these recomputes the 4D camera basis and redraws
+  var from4D = float4(0.0, 1.0, 0.0, 0.0) {
+    didSet {
+      updateViewpoint4D()
+      needsDisplay = true
+    }
+  }
+  var to4D = float4(0.0, 0.0, 0.0, 0.0) {
+    didSet {
+      updateViewpoint4D()
+      needsDisplay = true
+    }
+  }
+  var up4D = float4(0.0, 0.0, 1.0, 0.0) {
+    didSet {
+      updateViewpoint4D()
+      needsDisplay = true
+    }
+  }
+  var over4D = float4(0.0, 0.0, 0.0, 1.0) {
+    didSet {
+      updateViewpoint4D()
+      needsDisplay = true
+    }
+  }
+  
   var modifierKey: Int = 0
   
   var modelMatrix = matrix_identity_float4x4
@@ -49,18 +78,28 @@ class MetalView: MTKView {
   
   var renderingConstants = RenderingConstants()
   var projectionParameters = ProjectionParameters()
-  var faces = [Vertex]()
-  var edges = [Vertex]()
-  var edgeVerticesCount = [UInt]()
-  var vertices = [Vertex]()
-  var faces4DBuffer: MTLBuffer?
-  var faces3DBuffer: MTLBuffer?
-  var edges4DBuffer: MTLBuffer?
-  var edges3DBuffer: MTLBuffer?
-  var edgesEdgesBuffer: MTLBuffer?
-  var vertices4DBuffer: MTLBuffer?
-  var vertices3DBuffer: MTLBuffer?
-  var verticesFacesBuffer: MTLBuffer?
+  var cppLink: CppLinkWrapperWrapper?
+  var projectionNeeded = true
+  var facesCount = 0
+  var edgesCount = 0
+  var edgeIndicesCount = 0
+  var verticesCount = 0
+  var edgesStart = 0
+  var verticesStart = 0
+  var geometry4DBuffer: MTLBuffer?
+  var geometry3DBuffer: MTLBuffer?
+  var edgeIndexBuffer: MTLBuffer?
+  var sphereBuffer: MTLBuffer?
+  var sphereVertexCount = 0
+  
+  // Vertices are drawn as instances of one sphere with this radius, which is
+  // an icosahedron subdivided sphereRefinements times
+  var sphereRadius: Float = 0.02
+  var sphereRefinements: UInt = 1 {
+    didSet {
+      generateSphere()
+    }
+  }
   
   required init(coder: NSCoder) {
     
@@ -82,6 +121,7 @@ class MetalView: MTKView {
     
     // Compute pipeline
     let projectionFunction = library.makeFunction(name: "stereographicProjection")
+//    let projectionFunction = library.makeFunction(name: "fastStereographicProjection")
 //    let projectionFunction = library.makeFunction(name: "orthographicProjection")
 //    let projectionFunction = library.makeFunction(name: "longAxisProjection")
     do {
@@ -107,6 +147,8 @@ class MetalView: MTKView {
     renderPipelineDescriptor.depthAttachmentPixelFormat = depthStencilPixelFormat
     do {
       renderPipelineState = try device!.makeRenderPipelineState(descriptor: renderPipelineDescriptor)
+      renderPipelineDescriptor.vertexFunction = library.makeFunction(name: "vertexSphere")
+      sphereRenderPipelineState = try device!.makeRenderPipelineState(descriptor: renderPipelineDescriptor)
     } catch {
       Swift.print("Unable to compile render pipeline state")
       return
@@ -124,124 +166,66 @@ class MetalView: MTKView {
     projectionMatrix = matrix4x4_perspective(fieldOfView: fieldOfView, aspectRatio: Float(bounds.size.width / bounds.size.height), nearZ: 0.01, farZ: 10.0)
     
     renderingConstants.modelViewProjectionMatrix = matrix_multiply(projectionMatrix, matrix_multiply(viewMatrix, modelMatrix))
+    updateViewpoint4D()
+    generateSphere()
     
     // Create data
-    let cppLink = CppLinkWrapperWrapper()!
-//    cppLink.makeTesseract()
-    cppLink.makeHouse()
-//    cppLink.makeCorridor()
-    
-    // Get faces
-    cppLink.initialiseFacesIterator()
-    while !cppLink.facesIteratorEnded() {
-      cppLink.initialiseFaceTrianglesIterator()
-      let firstColourComponent = cppLink.currentFaceColour()
-      let colourBuffer = UnsafeBufferPointer(start: firstColourComponent, count: 4)
-      let colourArray = ContiguousArray(colourBuffer)
-      let colour = [Float](colourArray)
-      while !cppLink.faceTrianglesIteratorEnded() {
-        for pointIndex in 0..<3 {
-          let firstPointCoordinate = cppLink.currentFaceTriangleVertex(pointIndex)
-          let pointCoordinatesBuffer = UnsafeBufferPointer(start: firstPointCoordinate, count: 4)
-          let pointCoordinatesArray = ContiguousArray(pointCoordinatesBuffer)
-          let pointCoordinates = [Float](pointCoordinatesArray)
-//          Swift.print(pointCoordinates)
-          faces.append(Vertex(position: float4(pointCoordinates[0], pointCoordinates[1], pointCoordinates[2], pointCoordinates[3]),
-                              colour: float4(colour[0], colour[1], colour[2], colour[3])))
-        }
-        cppLink.advanceFaceTrianglesIterator()
-      }
-      cppLink.advanceFacesIterator()
-    }
-    Swift.print("\(faces.count) face vertices")
-    faces4DBuffer = device!.makeBuffer(bytes: faces, length: MemoryLayout<Vertex>.size*faces.count, options: [])
-    faces3DBuffer = device!.makeBuffer(length: MemoryLayout<Vertex>.size*faces.count, options: [])
-    
-    // Get edges
-    cppLink.initialiseEdgesIterator()
-    while !cppLink.edgesIteratorEnded() {
-      cppLink.initialiseEdgeVerticesIterator()
-      var verticesInEdgeCount: UInt = 0
-      while !cppLink.edgeVerticesIteratorEnded() {
-        let firstPointCoordinate = cppLink.currentEdgeVertex()
-        let pointCoordinatesBuffer = UnsafeBufferPointer(start: firstPointCoordinate, count: 4)
-        let pointCoordinatesArray = ContiguousArray(pointCoordinatesBuffer)
-        let pointCoordinates = [Float](pointCoordinatesArray)
-        edges.append(Vertex(position: float4(pointCoordinates[0], pointCoordinates[1], pointCoordinates[2], pointCoordinates[3]),
-                            colour: float4(0.0, 0.0, 0.0, 1.0)))
-//        Swift.print(edges.last!)
-        verticesInEdgeCount += 1
-        cppLink.advanceEdgeVerticesIterator()
-      }
-      edgeVerticesCount.append(verticesInEdgeCount)
-      cppLink.advanceEdgesIterator()
-    }
-//    Swift.print(edgeVerticesCount)
-    edges4DBuffer = device!.makeBuffer(bytes: edges, length: MemoryLayout<Vertex>.size*edges.count, options: [])
-    edges3DBuffer = device!.makeBuffer(length: MemoryLayout<Vertex>.size*edges.count, options: [])
-    
-    // Get vertices
-    cppLink.initialiseVerticesIterator()
-    while !cppLink.verticesIteratorEnded() {
-      let firstPointCoordinate = cppLink.currentVertex()
-      let pointCoordinatesBuffer = UnsafeBufferPointer(start: firstPointCoordinate, count: 4)
-      let pointCoordinatesArray = ContiguousArray(pointCoordinatesBuffer)
-      let pointCoordinates = [Float](pointCoordinatesArray)
-      vertices.append(Vertex(position: float4(pointCoordinates[0], pointCoordinates[1], pointCoordinates[2], pointCoordinates[3]),
-                             colour: float4(0.0, 0.0, 0.0, 1.0)))
-      cppLink.advanceVerticesIterator()
-    }
-    vertices4DBuffer = device!.makeBuffer(bytes: vertices, length: MemoryLayout<Vertex>.size*vertices.count, options: [])
-    vertices3DBuffer = device!.makeBuffer(length: MemoryLayout<Vertex>.size*vertices.count, options: [])
-    
-    
-    // Project faces
-    let facesCommandBuffer = commandQueue!.makeCommandBuffer()
-    let facesComputeCommandEncoder = facesCommandBuffer!.makeComputeCommandEncoder()
-    facesComputeCommandEncoder!.setComputePipelineState(computePipelineState!)
-    facesComputeCommandEncoder!.setBuffer(faces4DBuffer, offset: 0, index: 0)
-    facesComputeCommandEncoder!.setBuffer(faces3DBuffer, offset: 0, index: 1)
-    facesComputeCommandEncoder!.setBytes(&projectionParameters, length: MemoryLayout<ProjectionParameters>.size, index: 2)
-    let facesThreadsPerGroup = MTLSize(width: 16, height: 1, depth: 1)
-    let facesNumThreadGroups = MTLSize(width: faces.count/facesThreadsPerGroup.width, height: 1, depth: 1)
-    facesComputeCommandEncoder!.dispatchThreadgroups(facesNumThreadGroups, threadsPerThreadgroup: facesThreadsPerGroup)
-    facesComputeCommandEncoder!.endEncoding()
-    facesCommandBuffer!.commit()
-    
-    // Project edges
-    let edgesCommandBuffer = commandQueue!.makeCommandBuffer()
-    let edgesComputeCommandEncoder = edgesCommandBuffer!.makeComputeCommandEncoder()
-    edgesComputeCommandEncoder!.setComputePipelineState(computePipelineState!)
-    edgesComputeCommandEncoder!.setBuffer(edges4DBuffer, offset: 0, index: 0)
-    edgesComputeCommandEncoder!.setBuffer(edges3DBuffer, offset: 0, index: 1)
-    edgesComputeCommandEncoder!.setBytes(&projectionParameters, length: MemoryLayout<ProjectionParameters>.size, index: 2)
-    let edgesThreadsPerGroup = MTLSize(width: 16, height: 1, depth: 1)
-    let edgesNumThreadGroups = MTLSize(width: edges.count/edgesThreadsPerGroup.width, height: 1, depth: 1)
-    edgesComputeCommandEncoder!.dispatchThreadgroups(edgesNumThreadGroups, threadsPerThreadgroup: edgesThreadsPerGroup)
-    edgesComputeCommandEncoder!.endEncoding()
-    edgesCommandBuffer!.commit()
-    
-    // Project vertices
-    let verticesCommandBuffer = commandQueue!.makeCommandBuffer()
-    let verticesComputeCommandEncoder = verticesCommandBuffer!.makeComputeCommandEncoder()
-    verticesComputeCommandEncoder!.setComputePipelineState(computePipelineState!)
-    verticesComputeCommandEncoder!.setBuffer(vertices4DBuffer, offset: 0, index: 0)
-    verticesComputeCommandEncoder!.setBuffer(vertices3DBuffer, offset: 0, index: 1)
-    verticesComputeCommandEncoder!.setBytes(&projectionParameters, length: MemoryLayout<ProjectionParameters>.size, index: 2)
-    let verticesThreadsPerGroup = MTLSize(width: 16, height: 1, depth: 1)
-    let verticesNumThreadGroups = MTLSize(width: vertices.count/verticesThreadsPerGroup.width, height: 1, depth: 1)
-    verticesComputeCommandEncoder!.dispatchThreadgroups(verticesNumThreadGroups, threadsPerThreadgroup: verticesThreadsPerGroup)
-    verticesComputeCommandEncoder!.endEncoding()
-    verticesCommandBuffer!.commit()
+    cppLink = CppLinkWrapperWrapper()!
+//    cppLink!.makeTesseract()
+    cppLink!.makeHouse()
+//    cppLink!.makeCorridor()
+    
+    // Faces, edges and vertices are stored one after the other in the same
+    // buffers, so that a single dispatch projects them all
+    facesCount = cppLink!.numberOfFaceVertices()
+    Swift.print("\(facesCount) face vertices")
+    edgesCount = cppLink!.numberOfEdgeVertices()
+    verticesCount = cppLink!.numberOfVertices()
+    edgesStart = facesCount
+    verticesStart = facesCount+edgesCount
+    let geometryCount = facesCount+edgesCount+verticesCount
+    geometry4DBuffer = device!.makeBuffer(length: MemoryLayout<Vertex>.stride*geometryCount, options: [])
+    geometry3DBuffer = device!.makeBuffer(length: MemoryLayout<Vertex>.stride*geometryCount, options: [])
+    cppLink!.copyFaceVertices(geometry4DBuffer!.contents())
+    cppLink!.copyEdgeVertices(geometry4DBuffer!.contents().advanced(by: MemoryLayout<Vertex>.stride*edgesStart))
+    cppLink!.copyVertices(geometry4DBuffer!.contents().advanced(by: MemoryLayout<Vertex>.stride*verticesStart))
+    
+    // Edges are drawn as a line list indexing the projected edge vertices
+    edgeIndicesCount = cppLink!.numberOfEdgeSegmentIndices()
+    edgeIndexBuffer = device!.makeBuffer(length: max(MemoryLayout<UInt32>.stride*edgeIndicesCount, 1), options: [])
+    cppLink!.copyEdgeVertexSegmentIndices(edgeIndexBuffer!.contents().bindMemory(to: UInt32.self, capacity: edgeIndicesCount), first: UInt32(edgesStart))
   }
   
-  func generateVertices() {
-    let radius: Float = 0.02
-    let refinements: UInt = 1
-    
-    let vertexData = NSData(bytesNoCopy: vertices3DBuffer!.contents(), length: MemoryLayout<Vertex>.size*vertices.count, freeWhenDone: false)
-    var projectedVertices = [Vertex](vertices)
-    vertexData.getBytes(&projectedVertices, length: MemoryLayout<Vertex>.size*vertices.count)
+  // Projects faces, edges and vertices with the rotation accumulated so far,
+  // ahead of the rendering in the same command buffer
+  func encodeProjection(commandBuffer: MTLCommandBuffer) {
+    cppLink!.copyTransformationMatrix(&projectionParameters.transformationMatrix)
+    let computeCommandEncoder = commandBuffer.makeComputeCommandEncoder()
+    computeCommandEncoder!.setComputePipelineState(computePipelineState!)
+    computeCommandEncoder!.setBuffer(geometry4DBuffer, offset: 0, index: 0)
+    computeCommandEncoder!.setBuffer(geometry3DBuffer, offset: 0, index: 1)
+    computeCommandEncoder!.setBytes(&projectionParameters, length: MemoryLayout<ProjectionParameters>.size, index: 2)
+    var count = UInt32(facesCount+edgesCount+verticesCount)
+    computeCommandEncoder!.setBytes(&count, length: MemoryLayout<UInt32>.size, index: 3)
+    
+    // One SIMD group per thread group, with enough groups to cover the tail,
+    // which the kernel skips past count
+    let threadsPerGroup = MTLSize(width: computePipelineState!.threadExecutionWidth, height: 1, depth: 1)
+    let numThreadGroups = MTLSize(width: (Int(count)+threadsPerGroup.width-1)/threadsPerGroup.width, height: 1, depth: 1)
+    computeCommandEncoder!.dispatchThreadgroups(numThreadGroups, threadsPerThreadgroup: threadsPerGroup)
+    computeCommandEncoder!.endEncoding()
+  }
+  
+  // The 4D camera only changes through from4D, to4D, up4D and over4D, so its
+  // basis is computed here once per change and not per vertex
+  func updateViewpoint4D() {
+    projectionParameters.viewBasis = matrix4x4_orthographic_basis(from: from4D, to: to4D, up: up4D, over: over4D)
+    projectionParameters.viewFrom = from4D
+    projectionNeeded = true
+  }
+  
+  // Unit sphere shared by all vertex markers, as a list of triangles
+  func generateSphere() {
     let goldenRatio: Float = (1.0+sqrtf(5.0))/2.0;
     let normalisingFactor: Float = sqrtf(goldenRatio*goldenRatio+1.0);
     
@@ -259,164 +243,35 @@ class MetalView: MTKView {
     icosahedronVertices.append(float4(-goldenRatio/normalisingFactor, 0.0, -1.0/normalisingFactor, 0.0))
     icosahedronVertices.append(float4(-goldenRatio/normalisingFactor, 0.0,  1.0/normalisingFactor, 0.0))
     
-    var verticesVertices = [Vertex]()
-    for vertex in projectedVertices {
-//      Swift.print(vertex)
-      var vertexVertices = [Vertex]()
-      
-//      Swift.print("Vertex: \(vertex.position)")
-//      Swift.print("Ico: \(vertex.position+icosahedronVertices[0])")
-      vertexVertices.append(Vertex(position: icosahedronVertices[0], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[11], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[5], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[0], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[5], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[1], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[0], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[1], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[7], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[0], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[7], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[10], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[0], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[10], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[11], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[1], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[5], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[9], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[5], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[11], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[4], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[11], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[10], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[2], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[10], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[7], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[6], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[7], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[1], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[8], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[3], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[9], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[4], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[3], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[4], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[2], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[3], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[2], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[6], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[3], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[6], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[8], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[3], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[8], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[9], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[4], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[9], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[5], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[2], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[4], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[11], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[6], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[2], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[10], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[8], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[6], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[7], colour: vertex.colour))
-      
-      vertexVertices.append(Vertex(position: icosahedronVertices[9], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[8], colour: vertex.colour))
-      vertexVertices.append(Vertex(position: icosahedronVertices[1], colour: vertex.colour))
-      
-      for _ in 0..<refinements {
-        var vertexVerticesRefined = [Vertex]()
-        
-        for currentVertexVerticesIndex in 0..<vertexVertices.count/3 {
-          let currentVertex0 = vertexVertices[3*currentVertexVerticesIndex]
-          let currentVertex1 = vertexVertices[3*currentVertexVerticesIndex+1]
-          let currentVertex2 = vertexVertices[3*currentVertexVerticesIndex+2]
-          
-          var midPoint01 = Vertex(position: 0.5*(currentVertex0.position+currentVertex1.position), colour: currentVertex0.colour)
-          var midPoint12 = Vertex(position: 0.5*(currentVertex1.position+currentVertex2.position), colour: currentVertex1.colour)
-          var midPoint20 = Vertex(position: 0.5*(currentVertex2.position+currentVertex0.position), colour: currentVertex2.colour)
-          
-          let midPointDistanceToOrigin: Float = sqrtf(midPoint01.position.x*midPoint01.position.x+midPoint01.position.y*midPoint01.position.y+midPoint01.position.z*midPoint01.position.z)
-          midPoint01.position *= 1.0/midPointDistanceToOrigin
-          midPoint12.position *= 1.0/midPointDistanceToOrigin
-          midPoint20.position *= 1.0/midPointDistanceToOrigin
-          
-          vertexVerticesRefined.append(currentVertex0)
-          vertexVerticesRefined.append(midPoint01)
-          vertexVerticesRefined.append(midPoint20)
-          
-          vertexVerticesRefined.append(currentVertex1)
-          vertexVerticesRefined.append(midPoint12)
-          vertexVerticesRefined.append(midPoint01)
-          
-          vertexVerticesRefined.append(currentVertex2)
-          vertexVerticesRefined.append(midPoint20)
-          vertexVerticesRefined.append(midPoint12)
-          
-          vertexVerticesRefined.append(midPoint01)
-          vertexVerticesRefined.append(midPoint12)
-          vertexVerticesRefined.append(midPoint20)
-        }
-        
-        vertexVertices = vertexVerticesRefined
-      }
-      
-      var vertexVerticesTranslated = [Vertex]()
-      for vertexVertex in vertexVertices {
-        vertexVerticesTranslated.append(Vertex(position: vertex.position+(radius*vertexVertex.position), colour: vertex.colour))
-      }
-      
-      verticesVertices.append(contentsOf: vertexVerticesTranslated)
-    }
-    
-    verticesFacesBuffer = device!.makeBuffer(bytes: verticesVertices, length: MemoryLayout<Vertex>.size*verticesVertices.count, options: [])
-  }
-  
-  func generateEdges() {
-    
-    let edgeData = NSData(bytesNoCopy: edges3DBuffer!.contents(), length: MemoryLayout<Vertex>.size*edges.count, freeWhenDone: false)
-    var projectedEdges = [Vertex](edges)
-    edgeData.getBytes(&projectedEdges, length: MemoryLayout<Vertex>.size*edges.count)
+    let icosahedronTriangles: [Int] = [0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+                                       1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+                                       3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+                                       4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1]
+    var sphereVertices = icosahedronTriangles.map { icosahedronVertices[$0] }
     
-    var startIndex: Int = 0
-    var edgeEdges = [Vertex]()
-    for verticesCountInCurrentEdge in edgeVerticesCount {
-      let endIndex: Int = startIndex+Int(verticesCountInCurrentEdge)-1
-//      Swift.print("Start: \(startIndex) End: \(endIndex)")
+    for _ in 0..<sphereRefinements {
+      var sphereVerticesRefined = [float4]()
       
-      for startSubindex in startIndex..<endIndex {
-        let endSubindex: Int = startSubindex+1
+      for currentTriangle in 0..<sphereVertices.count/3 {
+        let currentVertex0 = sphereVertices[3*currentTriangle]
+        let currentVertex1 = sphereVertices[3*currentTriangle+1]
+        let currentVertex2 = sphereVertices[3*currentTriangle+2]
         
-        edgeEdges.append(projectedEdges[startSubindex])
-        edgeEdges.append(projectedEdges[endSubindex])
+        let midPoint01 = normalize(0.5*(currentVertex0+currentVertex1))
+        let midPoint12 = normalize(0.5*(currentVertex1+currentVertex2))
+        let midPoint20 = normalize(0.5*(currentVertex2+currentVertex0))
+        
+        sphereVerticesRefined.append(contentsOf: [currentVertex0, midPoint01, midPoint20,
+                                                  currentVertex1, midPoint12, midPoint01,
+                                                  currentVertex2, midPoint20, midPoint12,
+                                                  midPoint01, midPoint12, midPoint20])
       }
       
-      startIndex += Int(verticesCountInCurrentEdge)
+      sphereVertices = sphereVerticesRefined
     }
     
-    edgesEdgesBuffer = device!.makeBuffer(bytes: edgeEdges, length: MemoryLayout<Vertex>.size*edgeEdges.count, options: [])
+    sphereVertexCount = sphereVertices.count
+    sphereBuffer = device!.makeBuffer(bytes: sphereVertices, length: MemoryLayout<float4>.stride*sphereVertexCount, options: [])
   }
   
   override var acceptsFirstResponder: Bool {
@@ -427,6 +282,10 @@ class MetalView: MTKView {
 //    Swift.print("MetalView.draw(NSRect)")
     
     let commandBuffer = commandQueue!.makeCommandBuffer()
+    if projectionNeeded {
+      encodeProjection(commandBuffer: commandBuffer!)
+      projectionNeeded = false
+    }
     let renderPassDescriptor = currentRenderPassDescriptor!
     let renderEncoder = commandBuffer!.makeRenderCommandEncoder(descriptor: renderPassDescriptor)
     
@@ -437,29 +296,31 @@ class MetalView: MTKView {
 //    let colour = sin(CACurrentMediaTime())
 //    clearColor = MTLClearColorMake(colour, colour, colour, 1.0)
     
-    if verticesFacesBuffer != nil {
-      renderEncoder!.setVertexBuffer(verticesFacesBuffer, offset: 0, index: 0)
-      renderEncoder!.setVertexBytes(&renderingConstants, length: MemoryLayout<RenderingConstants>.size, index: 1)
-      renderEncoder!.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: verticesFacesBuffer!.length/MemoryLayout<Vertex>.size)
+    // One sphere instance per projected vertex
+    if verticesCount > 0 {
+      renderEncoder!.setRenderPipelineState(sphereRenderPipelineState!)
+      renderEncoder!.setVertexBuffer(sphereBuffer, offset: 0, index: 0)
+      renderEncoder!.setVertexBuffer(geometry3DBuffer, offset: MemoryLayout<Vertex>.stride*verticesStart, index: 1)
+      renderEncoder!.setVertexBytes(&renderingConstants, length: MemoryLayout<RenderingConstants>.size, index: 2)
+      renderEncoder!.setVertexBytes(&sphereRadius, length: MemoryLayout<Float>.size, index: 3)
+      renderEncoder!.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: sphereVertexCount, instanceCount: verticesCount)
+      renderEncoder!.setRenderPipelineState(renderPipelineState!)
     }
     
-    if edgesEdgesBuffer != nil {
-      renderEncoder!.setVertexBuffer(edgesEdgesBuffer, offset: 0, index: 0)
+    if edgeIndicesCount > 0 {
+      renderEncoder!.setVertexBuffer(geometry3DBuffer, offset: 0, index: 0)
       renderEncoder!.setVertexBytes(&renderingConstants, length: MemoryLayout<RenderingConstants>.size, index: 1)
-      renderEncoder!.drawPrimitives(type: .line, vertexStart: 0, vertexCount: edgesEdgesBuffer!.length/MemoryLayout<Vertex>.size)
+      renderEncoder!.drawIndexedPrimitives(type: .line, indexCount: edgeIndicesCount, indexType: .uint32, indexBuffer: edgeIndexBuffer!, indexBufferOffset: 0)
     }
     
-    renderEncoder!.setVertexBuffer(faces3DBuffer, offset: 0, index: 0)
+    renderEncoder!.setVertexBuffer(geometry3DBuffer, offset: 0, index: 0)
     renderEncoder!.setVertexBytes(&renderingConstants, length: MemoryLayout<RenderingConstants>.size, index: 1)
-    renderEncoder!.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: faces3DBuffer!.length/MemoryLayout<Vertex>.size)
+    renderEncoder!.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: facesCount)
     
     renderEncoder!.endEncoding()
     let drawable = currentDrawable!
     commandBuffer!.present(drawable)
     commandBuffer!.commit()
-    
-    generateVertices()
-    generateEdges()
   }
   
   override func setFrameSize(_ newSize: NSSize) {
@@ -508,86 +369,19 @@ class MetalView: MTKView {
       return
     }
     
-    // Compute the motions and apply them
+    // Accumulate the motions, which are projected once in the next frame
+    let angleX = Double(currentX-lastX)
+    let angleY = Double(currentY-lastY)
     if modifierKey == 0 {
-      let angleX = currentX-lastX
-      let rotationXY = matrix_from_columns(vector4(cos(angleX), -sin(angleX), 0.0, 0.0),
-                                           vector4(sin(angleX), cos(angleX), 0.0, 0.0),
-                                           vector4(0.0, 0.0, 1.0, 0.0),
-                                           vector4(0.0, 0.0, 0.0, 1.0))
-      let angleY = currentY-lastY
-      let rotationZW = matrix_from_columns(vector4(1.0, 0.0, 0.0, 0.0),
-                                           vector4(0.0, 1.0, 0.0, 0.0),
-                                           vector4(0.0, 0.0, cos(angleY), -sin(angleY)),
-                                           vector4(0.0, 0.0, sin(angleY), cos(angleY)))
-      projectionParameters.transformationMatrix = matrix_multiply(rotationXY, projectionParameters.transformationMatrix)
-      projectionParameters.transformationMatrix = matrix_multiply(rotationZW, projectionParameters.transformationMatrix)
+      cppLink!.rotateFrom(0, to: 1, angle: -angleX)
+      cppLink!.rotateFrom(2, to: 3, angle: -angleY)
     } else if modifierKey == 1 {
-      let angleX = currentX-lastX
-      let rotationYZ = matrix_from_columns(vector4(1.0, 0.0, 0.0, 0.0),
-                                           vector4(0.0, cos(angleX), -sin(angleX), 0.0),
-                                           vector4(0.0, sin(angleX), cos(angleX), 0.0),
-                                           vector4(0.0, 0.0, 0.0, 1.0))
-      let angleY = currentY-lastY
-      let rotationWX = matrix_from_columns(vector4(cos(angleY), 0.0, 0.0, sin(angleY)),
-                                           vector4(0.0, 1.0, 0.0, 0.0),
-                                           vector4(0.0, 0.0, 1.0, 0.0),
-                                           vector4(-sin(angleY), 0.0, 0.0, cos(angleY)))
-      projectionParameters.transformationMatrix = matrix_multiply(rotationYZ, projectionParameters.transformationMatrix)
-      projectionParameters.transformationMatrix = matrix_multiply(rotationWX, projectionParameters.transformationMatrix)
+      cppLink!.rotateFrom(1, to: 2, angle: -angleX)
+      cppLink!.rotateFrom(0, to: 3, angle: angleY)
     } else {
-      let angleX = currentX-lastX
-      let rotationXZ = matrix_from_columns(vector4(cos(angleX), 0.0, -sin(angleX), 0.0),
-                                           vector4(0.0, 1.0, 0.0, 0.0),
-                                           vector4(sin(angleX), 0.0, cos(angleX), 0.0),
-                                           vector4(0.0, 0.0, 0.0, 1.0))
-      let angleY = currentY-lastY
-      let rotationYW = matrix_from_columns(vector4(1.0, 0.0, 0.0, 0.0),
-                                           vector4(0.0, cos(angleY), 0.0, sin(angleY)),
-                                           vector4(0.0, 0.0, 1.0, 0.0),
-                                           vector4(0.0, -sin(angleY), 0.0, cos(angleY)))
-      projectionParameters.transformationMatrix = matrix_multiply(rotationXZ, projectionParameters.transformationMatrix)
-      projectionParameters.transformationMatrix = matrix_multiply(rotationYW, projectionParameters.transformationMatrix)
-    }
-
-    // Project faces
-    let facesCommandBuffer = commandQueue!.makeCommandBuffer()
-    let facesComputeCommandEncoder = facesCommandBuffer!.makeComputeCommandEncoder()
-    facesComputeCommandEncoder!.setComputePipelineState(computePipelineState!)
-    facesComputeCommandEncoder!.setBuffer(faces4DBuffer, offset: 0, index: 0)
-    facesComputeCommandEncoder!.setBuffer(faces3DBuffer, offset: 0, index: 1)
-    facesComputeCommandEncoder!.setBytes(&projectionParameters, length: MemoryLayout<ProjectionParameters>.size, index: 2)
-    let facesThreadsPerGroup = MTLSize(width: 16, height: 1, depth: 1)
-    let facesNumThreadGroups = MTLSize(width: faces.count/facesThreadsPerGroup.width, height: 1, depth: 1)
-    facesComputeCommandEncoder!.dispatchThreadgroups(facesNumThreadGroups, threadsPerThreadgroup: facesThreadsPerGroup)
-    facesComputeCommandEncoder!.endEncoding()
-    facesCommandBuffer!.commit()
-    
-    // Project edges
-    let edgesCommandBuffer = commandQueue!.makeCommandBuffer()
-    let edgesComputeCommandEncoder = edgesCommandBuffer!.makeComputeCommandEncoder()
-    edgesComputeCommandEncoder!.setComputePipelineState(computePipelineState!)
-    edgesComputeCommandEncoder!.setBuffer(edges4DBuffer, offset: 0, index: 0)
-    edgesComputeCommandEncoder!.setBuffer(edges3DBuffer, offset: 0, index: 1)
-    edgesComputeCommandEncoder!.setBytes(&projectionParameters, length: MemoryLayout<ProjectionParameters>.size, index: 2)
-    let edgesThreadsPerGroup = MTLSize(width: 16, height: 1, depth: 1)
-    let edgesNumThreadGroups = MTLSize(width: edges.count/edgesThreadsPerGroup.width, height: 1, depth: 1)
-    edgesComputeCommandEncoder!.dispatchThreadgroups(edgesNumThreadGroups, threadsPerThreadgroup: edgesThreadsPerGroup)
-    edgesComputeCommandEncoder!.endEncoding()
-    edgesCommandBuffer!.commit()
-    
-    // Project vertices
-    let verticesCommandBuffer = commandQueue!.makeCommandBuffer()
-    let verticesComputeCommandEncoder = verticesCommandBuffer!.makeComputeCommandEncoder()
-    verticesComputeCommandEncoder!.setComputePipelineState(computePipelineState!)
-    verticesComputeCommandEncoder!.setBuffer(vertices4DBuffer, offset: 0, index: 0)
-    verticesComputeCommandEncoder!.setBuffer(vertices3DBuffer, offset: 0, index: 1)
-    verticesComputeCommandEncoder!.setBytes(&projectionParameters, length: MemoryLayout<ProjectionParameters>.size, index: 2)
-    let verticesThreadsPerGroup = MTLSize(width: 16, height: 1, depth: 1)
-    let verticesNumThreadGroups = MTLSize(width: vertices.count/verticesThreadsPerGroup.width, height: 1, depth: 1)
-    verticesComputeCommandEncoder!.dispatchThreadgroups(verticesNumThreadGroups, threadsPerThreadgroup: verticesThreadsPerGroup)
-    verticesComputeCommandEncoder!.endEncoding()
-    verticesCommandBuffer!.commit()
+      cppLink!.rotateFrom(0, to: 2, angle: -angleX)
+      cppLink!.rotateFrom(1, to: 3, angle: angleY)
+    } projectionNeeded = true
   }
   
   override func flagsChanged(with event: NSEvent) {
@@ -0,0 +1,64 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef Model_hpp
+#define Model_hpp
+
+#include <cstdint>
+#include <vector>
+
+#include "Geometry4.hpp"
+#include "RefinementPolicy.hpp"
+
+struct Polygon_d {
+  std::vector<Point4> vertices;
+  
+  // Calls function(i, j) for each of the n edges from vertices[i] to
+  // vertices[j] of the closed ring, ending with the closing edge from the
+  // last vertex back to the first
+  template <class Function>
+  void forEachEdge(Function function) const {
+    std::size_t numberOfVertices = vertices.size();
+    if (numberOfVertices < 2) return;
+    for (std::size_t vertex = 0; vertex+1 < numberOfVertices; ++vertex) function(vertex, vertex+1);
+    function(numberOfVertices-1, 0);
+  }
+};
+
+// Input to CppLink::load(): polygon i is drawn with materials[materialOfFace[i]]
+// and refined as set in refinementPolicy
+struct Model_d {
+  std::vector<Polygon_d> polygons;
+  std::vector<std::uint32_t> materialOfFace;
+  std::vector<Float4> materials;
+  RefinementPolicy refinementPolicy;
+};
+
+// Triangle mesh with shared vertices: triangle i uses vertices[triangles[3*i]],
+// vertices[triangles[3*i+1]] and vertices[triangles[3*i+2]]
+struct Mesh_d {
+  std::vector<Point4> vertices;
+  std::vector<std::uint32_t> triangles;
+  
+  std::size_t numberOfTriangles() const { return triangles.size()/3; }
+};
+
+struct Edge_d {
+  std::vector<Point4> vertices;
+};
+
+#endif /* Model_hpp */
@@ -0,0 +1,158 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ModelReader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#include "PlaneProjection.hpp"
+
+// Shortest possible material or vertex line ("0 0 0 0") and face line
+// ("3 0 0 0 0"), which bound how many of them the rest of a file can hold
+static const std::size_t shortestRecordLine = 7;
+static const std::size_t shortestFaceLine = 9;
+
+// Counts from the file are trusted up to this many elements when reserving
+// memory; vectors grow past it as elements are actually read
+static const std::size_t maximumReserve = 1 << 20;
+
+// Reads the next line with content into line, without its comment
+bool ModelReader::nextLine() {
+  while (std::getline(file, line)) {
+    ++lineNumber;
+    std::size_t comment = line.find('#');
+    if (comment != std::string::npos) line.erase(comment);
+    if (line.find_first_not_of(" \t\r") != std::string::npos) return true;
+  } return false;
+}
+
+bool ModelReader::fail(const std::string &message) {
+  error = "line "+std::to_string(lineNumber)+": "+message;
+  return false;
+}
+
+static bool atEnd(const char *text) {
+  while (*text == ' ' || *text == '\t' || *text == '\r') ++text;
+  return *text == '\0';
+}
+
+// Parses count numbers from text, returning whether there were exactly that
+// many and all finite, since strtod also reads nan, inf and overflows
+static bool parseNumbers(const char *text, std::size_t count, double *numbers) {
+  char *end;
+  for (std::size_t number = 0; number < count; ++number) {
+    numbers[number] = std::strtod(text, &end);
+    if (end == text || !std::isfinite(numbers[number])) return false;
+    text = end;
+  } return atEnd(text);
+}
+
+static bool parseIndex(const char *&text, unsigned long &index) {
+  char *end;
+  while (*text == ' ' || *text == '\t') ++text;
+  if (*text < '0' || *text > '9') return false;
+  index = std::strtoul(text, &end, 10);
+  text = end;
+  return true;
+}
+
+// Whether count is a whole number of things that fit in the given bytes
+static bool validCount(double count, std::uint64_t bytes, std::size_t bytesPerThing) {
+  return std::isfinite(count) && count >= 0.0 && count == std::floor(count) && count <= double(bytes/bytesPerThing);
+}
+
+bool ModelReader::open(const std::string &path) {
+  try {
+    return openFile(path);
+  } catch (const std::bad_alloc &) {
+    return fail("out of memory");
+  }
+}
+
+bool ModelReader::openFile(const std::string &path) {
+  file.open(path, std::ios::binary);
+  if (!file) {
+    error = "cannot open "+path;
+    return false;
+  } file.seekg(0, std::ios::end);
+  std::uint64_t fileSize = std::uint64_t(file.tellg());
+  file.seekg(0, std::ios::beg);
+  materials.clear();
+  vertices.clear();
+  lineNumber = 0;
+  facesRead = 0;
+  
+  if (!nextLine() || line.compare(0, 4, "4OFF") != 0) return fail("expected 4OFF");
+  double counts[3];
+  if (!nextLine() || !parseNumbers(line.c_str(), 3, counts)) return fail("expected the numbers of vertices, faces and materials");
+  
+  // Every count must fit in what is left of the file before it is used
+  std::uint64_t remaining = fileSize-std::min(fileSize, std::uint64_t(file.tellg()));
+  if (!validCount(counts[0], remaining, shortestRecordLine) || !validCount(counts[1], remaining, shortestFaceLine) ||
+      !validCount(counts[2], remaining, shortestRecordLine) || counts[2] < 1 ||
+      counts[0]*shortestRecordLine+counts[1]*shortestFaceLine+counts[2]*shortestRecordLine > double(remaining)) return fail("counts do not fit in the file");
+  std::size_t numberOfVertices = std::size_t(counts[0]), numberOfMaterials = std::size_t(counts[2]);
+  numberOfFaces = std::size_t(counts[1]);
+  
+  materials.reserve(std::min(numberOfMaterials, maximumReserve));
+  for (std::size_t material = 0; material < numberOfMaterials; ++material) {
+    double colour[4];
+    if (!nextLine() || !parseNumbers(line.c_str(), 4, colour)) return fail("expected a material as r g b a");
+    materials.push_back(Float4(colour[0], colour[1], colour[2], colour[3]));
+  }
+  
+  vertices.reserve(std::min(numberOfVertices, maximumReserve));
+  for (std::size_t vertex = 0; vertex < numberOfVertices; ++vertex) {
+    double coordinates[4];
+    if (!nextLine() || !parseNumbers(line.c_str(), 4, coordinates)) return fail("expected a vertex as x y z w");
+    vertices.push_back(Point4(coordinates[0], coordinates[1], coordinates[2], coordinates[3]));
+  } return true;
+}
+
+bool ModelReader::read(std::size_t count, std::vector<Polygon_d> &polygons, std::vector<std::uint32_t> &materialOfFace) {
+  try {
+    return readFaces(count, polygons, materialOfFace);
+  } catch (const std::bad_alloc &) {
+    return fail("out of memory");
+  }
+}
+
+bool ModelReader::readFaces(std::size_t count, std::vector<Polygon_d> &polygons, std::vector<std::uint32_t> &materialOfFace) {
+  for (std::size_t face = 0; face < count && facesRead < numberOfFaces; ++face, ++facesRead) {
+    if (!nextLine()) return fail("expected "+std::to_string(numberOfFaces)+" faces, found "+std::to_string(facesRead));
+    const char *text = line.c_str();
+    unsigned long numberOfVertices, index, material;
+    if (!parseIndex(text, numberOfVertices) || numberOfVertices < 3) return fail("expected a face with at least 3 vertices");
+    
+    // Every vertex index takes at least two characters
+    if (numberOfVertices > line.size()/2) return fail("expected "+std::to_string(numberOfVertices)+" vertex indices");
+    polygons.push_back(Polygon_d());
+    polygons.back().vertices.reserve(numberOfVertices);
+    for (unsigned long vertex = 0; vertex < numberOfVertices; ++vertex) {
+      if (!parseIndex(text, index) || index >= vertices.size()) return fail("expected a vertex index below "+std::to_string(vertices.size()));
+      polygons.back().vertices.push_back(vertices[index]);
+    } if (!parseIndex(text, material) || material >= materials.size() || !atEnd(text)) return fail("expected a material index below "+std::to_string(materials.size()));
+    
+    // Refinement needs a plane to triangulate the face in
+    Vector4 vector_01, vector_02;
+    if (!planeBasis(polygons.back().vertices.data(), polygons.back().vertices.size(), vector_01, vector_02)) return fail("degenerate face");
+    materialOfFace.push_back(std::uint32_t(material));
+  } return true;
+}
@@ -0,0 +1,69 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef ModelReader_hpp
+#define ModelReader_hpp
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Model.hpp"
+
+// Streaming reader for 4D polygon models in the 4OFF format, a 4D take on
+// OFF. Everything after a # is a comment and blank lines are skipped:
+//
+//   4OFF
+//   vertices faces materials
+//   r g b a              one line per material
+//   x y z w              one line per vertex
+//   n i_1 ... i_n m      one line per face: n vertex indices and a material
+//
+// Indices start at 0. The materials and vertices are read when the file is
+// opened, while faces are read in batches so that they can be processed as
+// the rest of the file is parsed, without ever holding its text in memory.
+class ModelReader {
+public:
+  std::vector<Float4> materials;
+  std::vector<Point4> vertices;
+  std::string error;
+  
+  // Reads everything up to the faces, returning false and setting error if
+  // the file cannot be opened or is malformed, including counts that the
+  // rest of the file is too short to hold
+  bool open(const std::string &path);
+  // Appends up to count faces to polygons and materialOfFace, returning
+  // false and setting error if the file is malformed
+  bool read(std::size_t count, std::vector<Polygon_d> &polygons, std::vector<std::uint32_t> &materialOfFace);
+  bool done() const { return facesRead == numberOfFaces; }
+  std::size_t faces() const { return numberOfFaces; }
+  
+private:
+  std::ifstream file;
+  std::string line;
+  std::size_t lineNumber = 0;
+  std::size_t numberOfFaces = 0;
+  std::size_t facesRead = 0;
+  
+  bool openFile(const std::string &path);
+  bool readFaces(std::size_t count, std::vector<Polygon_d> &polygons, std::vector<std::uint32_t> &materialOfFace);
+  bool nextLine();
+  bool fail(const std::string &message);
+};
+
+#endif /* ModelReader_hpp */
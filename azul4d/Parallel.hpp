@@ -0,0 +1,73 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef Parallel_hpp
+#define Parallel_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline std::size_t numberOfWorkerThreads() {
+  unsigned int hardwareThreads = std::thread::hardware_concurrency();
+  if (hardwareThreads == 0) return 1;
+  return hardwareThreads;
+}
+
+// Whether the calling thread is a parallelFor worker
+inline bool &insideParallelFor() {
+  thread_local bool inside = false;
+  return inside;
+}
+
+// Calls function(index) for every index in [0, count). Workers pull the next
+// index from a shared counter, so uneven work items balance themselves out.
+// The first exception thrown by a worker is rethrown in the calling thread.
+// Calls from within a worker run serially, so that nesting parallelFor does
+// not start more threads than there are cores.
+template <class Function>
+void parallelFor(std::size_t count, Function function) {
+  std::size_t numberOfThreads = std::min(numberOfWorkerThreads(), count);
+  if (numberOfThreads <= 1 || insideParallelFor()) {
+    for (std::size_t index = 0; index < count; ++index) function(index);
+    return;
+  }
+
+  std::atomic<std::size_t> nextIndex(0);
+  std::exception_ptr firstException;
+  std::mutex exceptionMutex;
+  std::vector<std::thread> threads;
+  threads.reserve(numberOfThreads);
+  for (std::size_t thread = 0; thread < numberOfThreads; ++thread) {
+    threads.emplace_back([&]() {
+      insideParallelFor() = true;
+      try {
+        for (std::size_t index = nextIndex++; index < count; index = nextIndex++) function(index);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(exceptionMutex);
+        if (!firstException) firstException = std::current_exception();
+        nextIndex = count;
+      }
+    });
+  } for (auto &thread : threads) thread.join();
+
+  if (firstException) std::rethrow_exception(firstException);
+}
+
+#endif /* Parallel_hpp */
@@ -0,0 +1,148 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "PlaneProjection.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PLANE_PROJECTION_AVX2
+#include <immintrin.h>
+#endif
+
+bool planeBasis(const Point4 *points, std::size_t count, Vector4 &vector_01, Vector4 &vector_02) {
+  std::size_t point = 1;
+  while (point < count && points[point] == points[0]) ++point;
+  if (point < count) {
+    vector_01 = points[point]-points[0];
+    vector_01 /= sqrt(vector_01.squared_length());
+    
+    // Points whose orthogonal part is lost in the rounding of their distance
+    // count as on the line
+    for (++point; point < count; ++point) {
+      Vector4 vector_0i = points[point]-points[0];
+      vector_02 = vector_0i-(vector_0i*vector_01)*vector_01;
+      double squaredLength = vector_02.squared_length();
+      if (squaredLength > 1e-20*vector_0i.squared_length() && std::isfinite(squaredLength)) {
+        vector_02 /= sqrt(squaredLength);
+        return true;
+      }
+    }
+  } vector_01 = Vector4(1.0, 0.0, 0.0, 0.0);
+  vector_02 = Vector4(0.0, 1.0, 0.0, 0.0);
+  return false;
+}
+
+static void projectToPlaneScalar(const Point4 *points, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *planar) {
+  for (std::size_t point = 0; point < count; ++point) {
+    Vector4 point_vector = points[point]-origin;
+    planar[point] = Point4(point_vector*vector_01, point_vector*vector_02, 0.0, 0.0);
+  }
+}
+
+static void projectFromPlaneScalar(const Point4 *planar, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *points) {
+  for (std::size_t point = 0; point < count; ++point) {
+    points[point] = origin+planar[point][0]*vector_01+planar[point][1]*vector_02;
+  }
+}
+
+#ifdef PLANE_PROJECTION_AVX2
+
+// The vector code adds and multiplies in the same order as the scalar code
+// and does not use FMA, so both round identically
+
+__attribute__((target("avx2")))
+static void projectToPlaneAvx2(const Point4 *points, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *planar) {
+  __m256d origin_coordinates[4], vector_01_coordinates[4], vector_02_coordinates[4];
+  for (unsigned int coordinate = 0; coordinate < 4; ++coordinate) {
+    origin_coordinates[coordinate] = _mm256_set1_pd(origin[coordinate]);
+    vector_01_coordinates[coordinate] = _mm256_set1_pd(vector_01[coordinate]);
+    vector_02_coordinates[coordinate] = _mm256_set1_pd(vector_02[coordinate]);
+  }
+  
+  // Four points at a time, transposed so that each register holds one coordinate of all four
+  std::size_t point = 0;
+  for (; point+4 <= count; point += 4) {
+    __m256d row_0 = _mm256_loadu_pd(points[point].coordinates);
+    __m256d row_1 = _mm256_loadu_pd(points[point+1].coordinates);
+    __m256d row_2 = _mm256_loadu_pd(points[point+2].coordinates);
+    __m256d row_3 = _mm256_loadu_pd(points[point+3].coordinates);
+    __m256d xz_01 = _mm256_unpacklo_pd(row_0, row_1);
+    __m256d yw_01 = _mm256_unpackhi_pd(row_0, row_1);
+    __m256d xz_23 = _mm256_unpacklo_pd(row_2, row_3);
+    __m256d yw_23 = _mm256_unpackhi_pd(row_2, row_3);
+    __m256d point_vector[4] = {
+      _mm256_sub_pd(_mm256_permute2f128_pd(xz_01, xz_23, 0x20), origin_coordinates[0]),
+      _mm256_sub_pd(_mm256_permute2f128_pd(yw_01, yw_23, 0x20), origin_coordinates[1]),
+      _mm256_sub_pd(_mm256_permute2f128_pd(xz_01, xz_23, 0x31), origin_coordinates[2]),
+      _mm256_sub_pd(_mm256_permute2f128_pd(yw_01, yw_23, 0x31), origin_coordinates[3])
+    };
+    
+    __m256d x = _mm256_mul_pd(point_vector[0], vector_01_coordinates[0]);
+    __m256d y = _mm256_mul_pd(point_vector[0], vector_02_coordinates[0]);
+    for (unsigned int coordinate = 1; coordinate < 4; ++coordinate) {
+      x = _mm256_add_pd(x, _mm256_mul_pd(point_vector[coordinate], vector_01_coordinates[coordinate]));
+      y = _mm256_add_pd(y, _mm256_mul_pd(point_vector[coordinate], vector_02_coordinates[coordinate]));
+    }
+    
+    // Back to one (x, y, 0, 0) per point
+    __m256d zero = _mm256_setzero_pd();
+    __m256d xy_02 = _mm256_unpacklo_pd(x, y);
+    __m256d xy_13 = _mm256_unpackhi_pd(x, y);
+    _mm256_storeu_pd(planar[point].coordinates, _mm256_permute2f128_pd(xy_02, zero, 0x20));
+    _mm256_storeu_pd(planar[point+1].coordinates, _mm256_permute2f128_pd(xy_13, zero, 0x20));
+    _mm256_storeu_pd(planar[point+2].coordinates, _mm256_permute2f128_pd(xy_02, zero, 0x31));
+    _mm256_storeu_pd(planar[point+3].coordinates, _mm256_permute2f128_pd(xy_13, zero, 0x31));
+  } projectToPlaneScalar(points+point, count-point, origin, vector_01, vector_02, planar+point);
+}
+
+__attribute__((target("avx2")))
+static void projectFromPlaneAvx2(const Point4 *planar, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *points) {
+  __m256d origin_coordinates = _mm256_loadu_pd(origin.coordinates);
+  __m256d vector_01_coordinates = _mm256_loadu_pd(vector_01.coordinates);
+  __m256d vector_02_coordinates = _mm256_loadu_pd(vector_02.coordinates);
+  for (std::size_t point = 0; point < count; ++point) {
+    __m256d x = _mm256_broadcast_sd(&planar[point].coordinates[0]);
+    __m256d y = _mm256_broadcast_sd(&planar[point].coordinates[1]);
+    _mm256_storeu_pd(points[point].coordinates, _mm256_add_pd(_mm256_add_pd(origin_coordinates, _mm256_mul_pd(x, vector_01_coordinates)), _mm256_mul_pd(y, vector_02_coordinates)));
+  }
+}
+
+static bool hasAvx2() {
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+
+#endif
+
+void projectToPlane(const Point4 *points, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *planar) {
+#ifdef PLANE_PROJECTION_AVX2
+  if (hasAvx2()) {
+    projectToPlaneAvx2(points, count, origin, vector_01, vector_02, planar);
+    return;
+  }
+#endif
+  projectToPlaneScalar(points, count, origin, vector_01, vector_02, planar);
+}
+
+void projectFromPlane(const Point4 *planar, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *points) {
+#ifdef PLANE_PROJECTION_AVX2
+  if (hasAvx2()) {
+    projectFromPlaneAvx2(planar, count, origin, vector_01, vector_02, points);
+    return;
+  }
+#endif
+  projectFromPlaneScalar(planar, count, origin, vector_01, vector_02, points);
+}
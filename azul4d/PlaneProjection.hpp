@@ -0,0 +1,44 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef PlaneProjection_hpp
+#define PlaneProjection_hpp
+
+#include <cstddef>
+
+#include "Geometry4.hpp"
+
+// Batch conversions between 4D points and coordinates in a plane through
+// origin spanned by the orthonormal vectors vector_01 and vector_02. Planar
+// coordinates are stored as Point4(x, y, 0, 0). Both use AVX2 when the
+// processor supports it and give the same results as the scalar code.
+
+// Orthonormal vectors spanning the plane of points through points[0]: the
+// direction to the first point that differs from it, and the part of the
+// direction to the next point off that line that is orthogonal to it. For
+// polygons whose first three vertices are distinct and not collinear, that is
+// the plane through vertices 0-2. Returns false, with the x and y axes, if
+// all points are on one line.
+bool planeBasis(const Point4 *points, std::size_t count, Vector4 &vector_01, Vector4 &vector_02);
+
+// planar[i] = ((points[i]-origin)*vector_01, (points[i]-origin)*vector_02, 0, 0)
+void projectToPlane(const Point4 *points, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *planar);
+
+// points[i] = origin+planar[i][0]*vector_01+planar[i][1]*vector_02
+void projectFromPlane(const Point4 *planar, std::size_t count, const Point4 &origin, const Vector4 &vector_01, const Vector4 &vector_02, Point4 *points);
+
+#endif /* PlaneProjection_hpp */
@@ -0,0 +1,233 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Polytopes.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Parallel.hpp"
+
+static const double pi = 3.141592653589793;
+static const double goldenRatio = (1.0+std::sqrt(5.0))/2.0;
+
+static Model_d singleMaterialModel(std::vector<Polygon_d> polygons) {
+  std::vector<Float4> materials(1, Float4(0.0, 0.0, 1.0, 0.2));
+  std::vector<std::uint32_t> materialOfFace(polygons.size(), 0);
+  return Model_d{std::move(polygons), std::move(materialOfFace), std::move(materials), RefinementPolicy()};
+}
+
+Model_d generateTesseractGrid(unsigned int n) {
+  if (n == 0 || n > maximumGridSize) return singleMaterialModel(std::vector<Polygon_d>());
+  
+  // Lattice coordinates are computed once from their indices, so that the
+  // same corner is bit for bit the same point in every square using it
+  std::vector<double> coordinateOf(n+1);
+  for (unsigned int index = 0; index <= n; ++index) coordinateOf[index] = -1.0+2.0*index/n;
+  
+  // Every slice with a fixed first index is generated on its own and the
+  // slices are then joined in order
+  std::vector<std::vector<Polygon_d>> slices(n+1);
+  parallelFor(n+1, [&](std::size_t slice) {
+    unsigned int index[4];
+    index[0] = (unsigned int)slice;
+    for (index[1] = 0; index[1] <= n; ++index[1]) {
+      for (index[2] = 0; index[2] <= n; ++index[2]) {
+        for (index[3] = 0; index[3] <= n; ++index[3]) {
+          for (unsigned int first = 0; first < 4; ++first) {
+            for (unsigned int second = first+1; second < 4; ++second) {
+              if (index[first] == n || index[second] == n) continue;
+              auto corner = [&](unsigned int firstStep, unsigned int secondStep) {
+                double coordinates[4];
+                for (unsigned int coordinate = 0; coordinate < 4; ++coordinate) coordinates[coordinate] = coordinateOf[index[coordinate]];
+                coordinates[first] = coordinateOf[index[first]+firstStep];
+                coordinates[second] = coordinateOf[index[second]+secondStep];
+                return Point4(coordinates);
+              };
+              slices[slice].push_back(Polygon_d());
+              std::vector<Point4> &square = slices[slice].back().vertices;
+              square.reserve(4);
+              square.push_back(corner(0, 0));
+              square.push_back(corner(1, 0));
+              square.push_back(corner(1, 1));
+              square.push_back(corner(0, 1));
+            }
+          }
+        }
+      }
+    }
+  });
+  
+  // 6 squares for every inner point, fewer on the boundary
+  std::vector<Polygon_d> grid;
+  grid.reserve(std::size_t(6)*n*n*(n+1)*(n+1));
+  for (auto &slice : slices) {
+    for (auto &square : slice) grid.push_back(std::move(square));
+    std::vector<Polygon_d>().swap(slice);
+  } return singleMaterialModel(std::move(grid));
+}
+
+// Whether every pair of vertices in the list is joined by an edge
+static std::vector<std::vector<bool>> adjacency(const std::vector<Point4> &vertices, double edgeLength) {
+  std::vector<std::vector<bool>> adjacent(vertices.size(), std::vector<bool>(vertices.size(), false));
+  for (std::size_t first = 0; first < vertices.size(); ++first) {
+    for (std::size_t second = first+1; second < vertices.size(); ++second) {
+      double distance = std::sqrt((vertices[second]-vertices[first]).squared_length());
+      if (std::abs(distance-edgeLength) < 1e-6*edgeLength) adjacent[first][second] = adjacent[second][first] = true;
+    }
+  } return adjacent;
+}
+
+// All triangles of mutually adjacent vertices, which are the faces of the
+// 24-cell and the 600-cell
+static std::vector<Polygon_d> triangles(const std::vector<Point4> &vertices, const std::vector<std::vector<bool>> &adjacent) {
+  std::vector<Polygon_d> faces;
+  for (std::size_t first = 0; first < vertices.size(); ++first) {
+    for (std::size_t second = first+1; second < vertices.size(); ++second) {
+      if (!adjacent[first][second]) continue;
+      for (std::size_t third = second+1; third < vertices.size(); ++third) {
+        if (!adjacent[first][third] || !adjacent[second][third]) continue;
+        faces.push_back(Polygon_d());
+        faces.back().vertices = {vertices[first], vertices[second], vertices[third]};
+      }
+    }
+  } return faces;
+}
+
+static std::vector<Point4> scaled(std::vector<Point4> vertices, double factor) {
+  for (auto &vertex : vertices) vertex = Point4(factor*vertex[0], factor*vertex[1], factor*vertex[2], factor*vertex[3]);
+  return vertices;
+}
+
+// Permutations of (±1, ±1, 0, 0), with circumradius sqrt(2) and edges sqrt(2) long
+static std::vector<Point4> vertices24Cell() {
+  std::vector<Point4> vertices;
+  for (unsigned int first = 0; first < 4; ++first) {
+    for (unsigned int second = first+1; second < 4; ++second) {
+      for (int signs = 0; signs < 4; ++signs) {
+        double coordinates[4] = {0.0, 0.0, 0.0, 0.0};
+        coordinates[first] = (signs & 1) ? -1.0 : 1.0;
+        coordinates[second] = (signs & 2) ? -1.0 : 1.0;
+        vertices.push_back(Point4(coordinates));
+      }
+    }
+  } return vertices;
+}
+
+// (±1, 0, 0, 0) and (±1/2, ±1/2, ±1/2, ±1/2) permuted and the even
+// permutations of (±φ, ±1, ±1/φ, 0)/2, with circumradius 1 and edges 1/φ long
+static std::vector<Point4> vertices600Cell() {
+  std::vector<Point4> vertices;
+  for (unsigned int axis = 0; axis < 4; ++axis) {
+    for (double sign : {1.0, -1.0}) {
+      double coordinates[4] = {0.0, 0.0, 0.0, 0.0};
+      coordinates[axis] = sign;
+      vertices.push_back(Point4(coordinates));
+    }
+  } for (int signs = 0; signs < 16; ++signs) {
+    double coordinates[4];
+    for (unsigned int coordinate = 0; coordinate < 4; ++coordinate) coordinates[coordinate] = (signs & (1 << coordinate)) ? -0.5 : 0.5;
+    vertices.push_back(Point4(coordinates));
+  }
+  
+  const unsigned int evenPermutations[12][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 0, 3, 2}, {1, 2, 0, 3}, {1, 3, 2, 0},
+                                                {2, 0, 1, 3}, {2, 1, 3, 0}, {2, 3, 0, 1}, {3, 0, 2, 1}, {3, 1, 0, 2}, {3, 2, 1, 0}};
+  const double values[4] = {goldenRatio/2.0, 0.5, 1.0/(2.0*goldenRatio), 0.0};
+  for (auto const &permutation : evenPermutations) {
+    for (int signs = 0; signs < 8; ++signs) {
+      double coordinates[4];
+      for (unsigned int value = 0; value < 4; ++value) coordinates[permutation[value]] = (signs & (1 << value)) ? -values[value] : values[value];
+      vertices.push_back(Point4(coordinates));
+    }
+  } return vertices;
+}
+
+Model_d generate24Cell() {
+  std::vector<Point4> vertices = vertices24Cell();
+  return singleMaterialModel(triangles(scaled(vertices, std::sqrt(2.0)), adjacency(vertices, std::sqrt(2.0))));
+}
+
+Model_d generate600Cell() {
+  std::vector<Point4> vertices = vertices600Cell();
+  return singleMaterialModel(triangles(scaled(vertices, 2.0), adjacency(vertices, 1.0/goldenRatio)));
+}
+
+Model_d generate120Cell() {
+  std::vector<Point4> vertices = vertices600Cell();
+  std::vector<std::vector<bool>> adjacent = adjacency(vertices, 1.0/goldenRatio);
+  
+  // A vertex of the 120-cell is the centre of a tetrahedron of the 600-cell,
+  // scaled out to circumradius 2. Its indices are sorted so that every
+  // tetrahedron gives exactly the same point wherever it is found.
+  auto centre = [&](std::size_t a, std::size_t b, std::size_t c, std::size_t d) {
+    std::size_t indices[4] = {a, b, c, d};
+    std::sort(indices, indices+4);
+    Vector4 sum(0.0, 0.0, 0.0, 0.0);
+    for (auto const &index : indices) sum = sum+(vertices[index]-Point4(0.0, 0.0, 0.0, 0.0));
+    double factor = 2.0/std::sqrt(sum.squared_length());
+    return Point4(factor*sum[0], factor*sum[1], factor*sum[2], factor*sum[3]);
+  };
+  
+  // Each edge ab of the 600-cell is surrounded by five tetrahedra abc_ic_i+1,
+  // where the common neighbours c_i of a and b form a ring, and their centres
+  // are a pentagon of the 120-cell
+  std::vector<std::pair<std::size_t, std::size_t>> edges;
+  for (std::size_t first = 0; first < vertices.size(); ++first) {
+    for (std::size_t second = first+1; second < vertices.size(); ++second) if (adjacent[first][second]) edges.push_back(std::make_pair(first, second));
+  } std::vector<Polygon_d> pentagons(edges.size());
+  parallelFor(edges.size(), [&](std::size_t edge) {
+    std::size_t a = edges[edge].first, b = edges[edge].second;
+    std::vector<std::size_t> ring;
+    for (std::size_t vertex = 0; vertex < vertices.size(); ++vertex) if (adjacent[a][vertex] && adjacent[b][vertex]) ring.push_back(vertex);
+    for (std::size_t position = 1; position < ring.size(); ++position) {
+      for (std::size_t next = position; next < ring.size(); ++next) {
+        if (adjacent[ring[position-1]][ring[next]]) {
+          std::swap(ring[position], ring[next]);
+          break;
+        }
+      }
+    } for (std::size_t position = 0; position < ring.size(); ++position) {
+      pentagons[edge].vertices.push_back(centre(a, b, ring[position], ring[(position+1)%ring.size()]));
+    }
+  });
+  return singleMaterialModel(std::move(pentagons));
+}
+
+Model_d generateDuoprism(unsigned int p, unsigned int q) {
+  std::vector<Polygon_d> faces;
+  if (p < 3 || q < 3 || p > maximumDuoprismSides || q > maximumDuoprismSides) return singleMaterialModel(faces);
+  
+  // Vertex (i, j) is (cos, sin) of i/p of a turn followed by (cos, sin) of
+  // j/q of a turn, all times sqrt(2)
+  auto vertex = [&](unsigned int i, unsigned int j) {
+    double first = 2.0*pi*(i%p)/p, second = 2.0*pi*(j%q)/q, radius = std::sqrt(2.0);
+    return Point4(radius*std::cos(first), radius*std::sin(first), radius*std::cos(second), radius*std::sin(second));
+  };
+  faces.reserve(p+q+std::size_t(p)*q);
+  for (unsigned int j = 0; j < q; ++j) {
+    faces.push_back(Polygon_d());
+    for (unsigned int i = 0; i < p; ++i) faces.back().vertices.push_back(vertex(i, j));
+  } for (unsigned int i = 0; i < p; ++i) {
+    faces.push_back(Polygon_d());
+    for (unsigned int j = 0; j < q; ++j) faces.back().vertices.push_back(vertex(i, j));
+  } for (unsigned int i = 0; i < p; ++i) {
+    for (unsigned int j = 0; j < q; ++j) {
+      faces.push_back(Polygon_d());
+      faces.back().vertices = {vertex(i, j), vertex(i+1, j), vertex(i+1, j+1), vertex(i, j+1)};
+    }
+  } return singleMaterialModel(std::move(faces));
+}
@@ -0,0 +1,45 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef Polytopes_hpp
+#define Polytopes_hpp
+
+#include "Model.hpp"
+
+// Generators for the 2-faces of 4D polytopes, with the same structure as
+// CppLink::generateTesseract(): one material and, except for the grid, a
+// circumradius of 2 like the tesseract
+
+// Largest sizes the grid and duoprism generators accept, about 7 and 17
+// million squares; anything larger gives an empty model
+const unsigned int maximumGridSize = 32;
+const unsigned int maximumDuoprismSides = 4096;
+
+// n×n×n×n tesseracts filling [-1, 1]^4, each shared square once, in the same
+// order for any number of threads
+Model_d generateTesseractGrid(unsigned int n);
+// 96 triangles
+Model_d generate24Cell();
+// 1200 triangles
+Model_d generate600Cell();
+// 720 pentagons, built as the dual of the 600-cell
+Model_d generate120Cell();
+// Product of a p-gon and a q-gon: q p-gons, p q-gons and p*q squares, for
+// 3 <= p, q <= maximumDuoprismSides
+Model_d generateDuoprism(unsigned int p, unsigned int q);
+
+#endif /* Polytopes_hpp */
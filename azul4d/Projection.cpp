@@ -0,0 +1,191 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Projection.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Parallel.hpp"
+
+// Vertices are projected in blocks, one thread per block at a time, and each
+// block is a plain loop over contiguous float4 data that the compiler can
+// vectorise
+static const std::size_t verticesPerBlock = 4096;
+
+template <class Function>
+static void forEachBlock(std::size_t count, Function function) {
+  parallelFor((count+verticesPerBlock-1)/verticesPerBlock, [&](std::size_t block) {
+    std::size_t first = block*verticesPerBlock;
+    function(first, std::min(first+verticesPerBlock, count));
+  });
+}
+
+void stereographicProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters) {
+  forEachBlock(count, [&](std::size_t first, std::size_t last) {
+    for (std::size_t id = first; id < last; ++id) {
+      
+      // Apply 4D transformation
+      Float4 transformedVertex = projectionParameters.transformationMatrix*verticesIn[id].position;
+      float x = transformedVertex[0], y = transformedVertex[1], z = transformedVertex[2], w = transformedVertex[3];
+      
+      // Project from R4 to S3
+      float r = std::sqrt(x*x+y*y+z*z+w*w);
+      float point_s3[3];
+      
+      if (r != 0) point_s3[0] = std::acos(x/r);
+      else point_s3[0] = (x >= 0) ? 0.0f : 3.141592653589793f;
+      
+      if (y*y+z*z+w*w != 0) point_s3[1] = std::acos(y/std::sqrt(y*y+z*z+w*w));
+      else point_s3[1] = (y >= 0) ? 0.0f : 3.141592653589793f;
+      
+      if (z*z+w*w != 0) {
+        if (w >= 0) point_s3[2] = std::acos(z/std::sqrt(z*z+w*w));
+        else point_s3[2] = -std::acos(z/std::sqrt(z*z+w*w));
+      } else point_s3[2] = (w >= 0) ? 0.0f : 3.141592653589793f;
+      
+      // Project from S3 to R4
+      float point_r4[4];
+      point_r4[0] = std::cos(point_s3[0]);
+      point_r4[1] = std::sin(point_s3[0])*std::cos(point_s3[1]);
+      point_r4[2] = std::sin(point_s3[0])*std::sin(point_s3[1])*std::cos(point_s3[2]);
+      point_r4[3] = std::sin(point_s3[0])*std::sin(point_s3[1])*std::sin(point_s3[2]);
+      
+      // Project from R4 to R3 and output
+      verticesOut[id].position = Float4(point_r4[0]/(point_r4[3]-1), point_r4[1]/(point_r4[3]-1), point_r4[2]/(point_r4[3]-1), 1.0f);
+      verticesOut[id].colour = verticesIn[id].colour;
+    }
+  });
+}
+
+void fastStereographicProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters) {
+  forEachBlock(count, [&](std::size_t first, std::size_t last) {
+    for (std::size_t id = first; id < last; ++id) {
+      
+      // Apply 4D transformation
+      Float4 transformedVertex = projectionParameters.transformationMatrix*verticesIn[id].position;
+      float x = transformedVertex[0], y = transformedVertex[1], z = transformedVertex[2], w = transformedVertex[3];
+      
+      // Project from R4 to S3, where the origin goes to (1, 0, 0, 0) like in stereographicProjection
+      float r = std::sqrt(x*x+y*y+z*z+w*w);
+      float point_r4[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+      if (r != 0) {
+        point_r4[0] = x/r;
+        point_r4[1] = y/r;
+        point_r4[2] = z/r;
+        point_r4[3] = w/r;
+      }
+      
+      // Project from R4 to R3 and output
+      verticesOut[id].position = Float4(point_r4[0]/(point_r4[3]-1), point_r4[1]/(point_r4[3]-1), point_r4[2]/(point_r4[3]-1), 1.0f);
+      verticesOut[id].colour = verticesIn[id].colour;
+    }
+  });
+}
+
+static Float4 normalise4(const Float4 &v) {
+  float norm = std::sqrt(v[0]*v[0]+v[1]*v[1]+v[2]*v[2]+v[3]*v[3]);
+  return Float4(v[0]/norm, v[1]/norm, v[2]/norm, v[3]/norm);
+}
+
+static float determinant2(float a, float b, float c, float d) {
+  return a*d - b*c;
+}
+
+static float determinant3(float a, float b, float c, float d, float e, float f, float g, float h, float i) {
+  return a*determinant2(e, f, h, i) - b*determinant2(d, f, g, i) + c*determinant2(d, e, g, h);
+}
+
+static Float4 crossProduct4(const Float4 &u, const Float4 &v, const Float4 &w) {
+  return Float4(determinant3(u[1], u[2], u[3], v[1], v[2], v[3], w[1], w[2], w[3]),
+                -determinant3(u[0], u[2], u[3], v[0], v[2], v[3], w[0], w[2], w[3]),
+                determinant3(u[0], u[1], u[3], v[0], v[1], v[3], w[0], w[1], w[3]),
+                -determinant3(u[0], u[1], u[2], v[0], v[1], v[2], w[0], w[1], w[2]));
+}
+
+Matrix4 orthographicViewBasis(const Float4 &from, const Float4 &to, const Float4 &up, const Float4 &over) {
+  Matrix4 basis;
+  Float4 &a = basis.columns[0], &b = basis.columns[1], &c = basis.columns[2], &d = basis.columns[3];
+  d = normalise4(Float4(to[0]-from[0], to[1]-from[1], to[2]-from[2], to[3]-from[3]));  // Along y
+  a = normalise4(crossProduct4(up, over, d));  // Along x
+  b = normalise4(crossProduct4(over, d, a));   // Along z
+  c = crossProduct4(d, a, b);  // Along w
+  for (unsigned int coordinate = 0; coordinate < 4; ++coordinate) c[coordinate] *= 2.0f;
+  return basis;
+}
+
+void orthographicProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters) {
+  const Matrix4 &basis = projectionParameters.viewBasis;
+  const Float4 &from = projectionParameters.viewFrom;
+  forEachBlock(count, [&](std::size_t first, std::size_t last) {
+    for (std::size_t id = first; id < last; ++id) {
+      
+      // Apply 4D transformation
+      Float4 transformedVertex = projectionParameters.transformationMatrix*verticesIn[id].position;
+      
+      // (transformedVertex-from)*viewBasis, of which only the first three are kept
+      float eye[4];
+      for (unsigned int coordinate = 0; coordinate < 4; ++coordinate) eye[coordinate] = transformedVertex[coordinate]-from[coordinate];
+      
+      // Output
+      verticesOut[id].position = Float4(eye[0]*basis.columns[0][0]+eye[1]*basis.columns[0][1]+eye[2]*basis.columns[0][2]+eye[3]*basis.columns[0][3],
+                                        eye[0]*basis.columns[1][0]+eye[1]*basis.columns[1][1]+eye[2]*basis.columns[1][2]+eye[3]*basis.columns[1][3],
+                                        eye[0]*basis.columns[2][0]+eye[1]*basis.columns[2][1]+eye[2]*basis.columns[2][2]+eye[3]*basis.columns[2][3], 1.0f);
+      verticesOut[id].colour = verticesIn[id].colour;
+    }
+  });
+}
+
+void longAxisProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters) {
+  forEachBlock(count, [&](std::size_t first, std::size_t last) {
+    for (std::size_t id = first; id < last; ++id) {
+      
+      // Apply 4D transformation
+      Float4 transformedVertex = projectionParameters.transformationMatrix*verticesIn[id].position;
+      float longAxis[3] = {2.0f*transformedVertex[3], 0.0f*transformedVertex[3], 0.0f*transformedVertex[3]};
+      
+      // Output
+      verticesOut[id].position = Float4(transformedVertex[0]+longAxis[0], transformedVertex[2]+longAxis[2], transformedVertex[1]+longAxis[1], 1.0f);
+      verticesOut[id].colour = verticesIn[id].colour;
+    }
+  });
+}
+
+void project(Projection projection, const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters) {
+  switch (projection) {
+    case Projection::stereographic:
+      stereographicProjection(verticesIn, verticesOut, count, projectionParameters);
+      break;
+    case Projection::fastStereographic:
+      fastStereographicProjection(verticesIn, verticesOut, count, projectionParameters);
+      break;
+    case Projection::orthographic:
+      orthographicProjection(verticesIn, verticesOut, count, projectionParameters);
+      break;
+    case Projection::longAxis:
+      longAxisProjection(verticesIn, verticesOut, count, projectionParameters);
+      break;
+  }
+}
+
+bool projectionFromName(const std::string &name, Projection &projection) {
+  if (name == "stereographic") projection = Projection::stereographic;
+  else if (name == "fast-stereographic") projection = Projection::fastStereographic;
+  else if (name == "orthographic") projection = Projection::orthographic;
+  else if (name == "long-axis") projection = Projection::longAxis;
+  else return false;
+  return true;
+}
@@ -0,0 +1,83 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef Projection_hpp
+#define Projection_hpp
+
+#include <cstddef>
+#include <string>
+
+#include "Geometry4.hpp"
+
+// 4x4 matrix stored by columns, like float4x4 in Metal and simd
+struct Matrix4 {
+  Float4 columns[4];
+
+  static Matrix4 identity() {
+    Matrix4 matrix;
+    for (unsigned int column = 0; column < 4; ++column) {
+      for (unsigned int row = 0; row < 4; ++row) matrix.columns[column][row] = (column == row) ? 1.0f : 0.0f;
+    } return matrix;
+  }
+
+  Float4 operator*(const Float4 &v) const {
+    Float4 result;
+    for (unsigned int row = 0; row < 4; ++row) {
+      result[row] = columns[0][row]*v[0]+columns[1][row]*v[1]+columns[2][row]*v[2]+columns[3][row]*v[3];
+    } return result;
+  }
+};
+
+// Axes of an orthographic 4D camera at from looking at to, as the columns
+// x, z, 2w and y used by orthographicProjection
+Matrix4 orthographicViewBasis(const Float4 &from, const Float4 &to, const Float4 &up, const Float4 &over);
+
+// Same layout as ProjectionParameters in Shaders.metal
+struct ProjectionParameters {
+  Matrix4 transformationMatrix = Matrix4::identity();
+  Matrix4 viewBasis = orthographicViewBasis(Float4(0.0f, 1.0f, 0.0f, 0.0f), Float4(0.0f, 0.0f, 0.0f, 0.0f), Float4(0.0f, 0.0f, 1.0f, 0.0f), Float4(0.0f, 0.0f, 0.0f, 1.0f));
+  Float4 viewFrom = Float4(0.0f, 1.0f, 0.0f, 0.0f);
+  
+  void setViewpoint(const Float4 &from, const Float4 &to, const Float4 &up, const Float4 &over) {
+    viewBasis = orthographicViewBasis(from, to, up, over);
+    viewFrom = from;
+  }
+};
+
+// CPU counterparts of the projection kernels in Shaders.metal. Each one
+// reads count vertices from verticesIn and writes them to verticesOut, which
+// may be the same array, following the kernel's arithmetic step by step.
+// Large batches are split across threads.
+void stereographicProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters);
+// Same result as stereographicProjection up to rounding, without any
+// trigonometric functions, like fastStereographicProjection in Shaders.metal
+void fastStereographicProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters);
+void orthographicProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters);
+void longAxisProjection(const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters);
+
+enum class Projection {
+  stereographic,
+  fastStereographic,
+  orthographic,
+  longAxis
+};
+
+void project(Projection projection, const Vertex4 *verticesIn, Vertex4 *verticesOut, std::size_t count, const ProjectionParameters &projectionParameters);
+
+// Parses "stereographic", "fast-stereographic", "orthographic" or "long-axis"
+bool projectionFromName(const std::string &name, Projection &projection);
+
+#endif /* Projection_hpp */
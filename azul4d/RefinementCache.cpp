@@ -0,0 +1,165 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "RefinementCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "HashTables.hpp"
+
+// On-disk entries are native-endian: a magic number, the polygon and the
+// parameters it was refined with, and then the mesh
+static const std::uint32_t fileMagic = 0x617a6d31; // azm1
+
+template <class T>
+static void writeValue(std::ofstream &file, const T &value) {
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <class T>
+static void writeArray(std::ofstream &file, const std::vector<T> &values) {
+  writeValue(file, std::uint64_t(values.size()));
+  file.write(reinterpret_cast<const char *>(values.data()), values.size()*sizeof(T));
+}
+
+template <class T>
+static bool readValue(std::ifstream &file, T &value) {
+  return bool(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+// Arrays claiming more values than the rest of the file holds are rejected
+// before anything is allocated for them
+template <class T>
+static bool readArray(std::ifstream &file, std::uint64_t fileSize, std::vector<T> &values) {
+  std::uint64_t numberOfValues;
+  if (!readValue(file, numberOfValues)) return false;
+  std::uint64_t position = std::uint64_t(file.tellg());
+  if (position > fileSize || numberOfValues > (fileSize-position)/sizeof(T)) return false;
+  values.resize(numberOfValues);
+  return bool(file.read(reinterpret_cast<char *>(values.data()), numberOfValues*sizeof(T)));
+}
+
+std::uint64_t RefinementCache::key(const Polygon_d &polygon, double ratio, double size) {
+  std::uint64_t hash = mixBits(polygon.vertices.size());
+  for (auto const &vertex : polygon.vertices) hash = mixBits(hash ^ hashPoint4(vertex));
+  return mixBits(hash ^ hashPoint4(Point4(ratio, size, 0.0, 0.0)));
+}
+
+bool RefinementCache::matches(const Entry &entry, const Polygon_d &polygon, double ratio, double size) {
+  return entry.ratio == ratio && entry.size == size && entry.polygon == polygon.vertices;
+}
+
+std::string RefinementCache::path(std::uint64_t key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)key);
+  return directory + "/" + name;
+}
+
+bool RefinementCache::read(std::uint64_t key, Entry &entry) const {
+  std::string entryPath = path(key);
+  std::ifstream file(entryPath, std::ios::binary);
+  if (!file) return false;
+  auto readEntry = [&]() {
+    file.seekg(0, std::ios::end);
+    std::uint64_t fileSize = std::uint64_t(file.tellg());
+    file.seekg(0, std::ios::beg);
+    std::uint32_t magic;
+    if (!readValue(file, magic) || magic != fileMagic) return false;
+    Mesh_d mesh;
+    if (!readArray(file, fileSize, entry.polygon) || !readValue(file, entry.ratio) || !readValue(file, entry.size) ||
+        !readArray(file, fileSize, mesh.vertices) || !readArray(file, fileSize, mesh.triangles)) return false;
+    if (mesh.triangles.size() % 3 != 0) return false;
+    for (auto const &vertex : mesh.triangles) if (vertex >= mesh.vertices.size()) return false;
+    entry.mesh = std::make_shared<const Mesh_d>(std::move(mesh));
+    return true;
+  };
+  if (readEntry()) return true;
+  
+  // A corrupt entry is a miss, and removed so that it is rewritten
+  file.close();
+  std::remove(entryPath.c_str());
+  return false;
+}
+
+void RefinementCache::write(std::uint64_t key, const Entry &entry) const {
+  
+  // Written under a temporary name and renamed, so that readers never see a partial file
+  std::string finalPath = path(key);
+  std::string temporaryPath = finalPath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream file(temporaryPath, std::ios::binary);
+    if (!file) return;
+    writeValue(file, fileMagic);
+    writeArray(file, entry.polygon);
+    writeValue(file, entry.ratio);
+    writeValue(file, entry.size);
+    writeArray(file, entry.mesh->vertices);
+    writeArray(file, entry.mesh->triangles);
+    if (!file) {
+      file.close();
+      std::remove(temporaryPath.c_str());
+      return;
+    }
+  } if (std::rename(temporaryPath.c_str(), finalPath.c_str()) != 0) std::remove(temporaryPath.c_str());
+}
+
+std::shared_ptr<const Mesh_d> RefinementCache::find(const Polygon_d &polygon, double ratio, double size) {
+  std::uint64_t polygonKey = key(polygon, ratio, size);
+  {
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    auto entry = entries.find(polygonKey);
+    if (entry != entries.end() && matches(entry->second, polygon, ratio, size)) {
+      ++numberOfHits;
+      return entry->second.mesh;
+    }
+  }
+  
+  if (!directory.empty()) {
+    Entry stored;
+    if (read(polygonKey, stored) && matches(stored, polygon, ratio, size)) {
+      std::lock_guard<std::mutex> lock(entriesMutex);
+      entries[polygonKey] = stored;
+      ++numberOfHits;
+      return stored.mesh;
+    }
+  }
+  
+  ++numberOfMisses;
+  return nullptr;
+}
+
+std::shared_ptr<const Mesh_d> RefinementCache::insert(const Polygon_d &polygon, double ratio, double size, Mesh_d mesh) {
+  Entry entry{polygon.vertices, ratio, size, std::make_shared<const Mesh_d>(std::move(mesh))};
+  std::uint64_t polygonKey = key(polygon, ratio, size);
+  if (!directory.empty()) write(polygonKey, entry);
+  std::lock_guard<std::mutex> lock(entriesMutex);
+  entries[polygonKey] = entry;
+  return entry.mesh;
+}
+
+void RefinementCache::clear() {
+  std::lock_guard<std::mutex> lock(entriesMutex);
+  entries.clear();
+}
+
+std::size_t RefinementCache::size() const {
+  std::lock_guard<std::mutex> lock(entriesMutex);
+  return entries.size();
+}
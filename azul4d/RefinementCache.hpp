@@ -0,0 +1,74 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RefinementCache_hpp
+#define RefinementCache_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Model.hpp"
+
+// Refined meshes keyed by the exact vertices of the polygon and the
+// refinement parameters, so that constant inputs are only refined once.
+// Entries are kept in memory and, if directory is set, also stored there as
+// one file per entry so that they survive between runs. Disk errors are not
+// fatal: a file that cannot be read or written is simply a cache miss.
+// Safe to use from several threads at once.
+class RefinementCache {
+public:
+  // Existing directory for the on-disk store, or empty for memory only
+  std::string directory;
+  
+  // Cached refinement of polygon, or nullptr if there is none
+  std::shared_ptr<const Mesh_d> find(const Polygon_d &polygon, double ratio, double size);
+  
+  // Stores the refinement of polygon and returns the cached copy
+  std::shared_ptr<const Mesh_d> insert(const Polygon_d &polygon, double ratio, double size, Mesh_d mesh);
+  
+  // Empties the in-memory entries; the on-disk store is left as is
+  void clear();
+  
+  std::size_t size() const;
+  std::size_t hits() const { return numberOfHits; }
+  std::size_t misses() const { return numberOfMisses; }
+  
+private:
+  struct Entry {
+    std::vector<Point4> polygon;
+    double ratio;
+    double size;
+    std::shared_ptr<const Mesh_d> mesh;
+  };
+  
+  std::unordered_map<std::uint64_t, Entry> entries;
+  mutable std::mutex entriesMutex;
+  std::atomic<std::size_t> numberOfHits{0};
+  std::atomic<std::size_t> numberOfMisses{0};
+  
+  static std::uint64_t key(const Polygon_d &polygon, double ratio, double size);
+  static bool matches(const Entry &entry, const Polygon_d &polygon, double ratio, double size);
+  std::string path(std::uint64_t key) const;
+  bool read(std::uint64_t key, Entry &entry) const;
+  void write(std::uint64_t key, const Entry &entry) const;
+};
+
+#endif /* RefinementCache_hpp */
@@ -0,0 +1,52 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "RefinementPolicy.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+double RefinementPolicy::scaleAt(const Point4 &point) const {
+  if (!adaptive) return 1.0;
+  Vector4 pointVector = point-Point4(0.0, 0.0, 0.0, 0.0);
+  Vector4 poleVector = pole-Point4(0.0, 0.0, 0.0, 0.0);
+  double pointNorm = std::sqrt(pointVector.squared_length());
+  double poleNorm = std::sqrt(poleVector.squared_length());
+  if (pointNorm == 0.0 || poleNorm == 0.0) return 1.0;
+  double height = (pointVector*poleVector)/(pointNorm*poleNorm);
+  return std::min(std::max(pointNorm*(1.0-height), minimumScale), maximumScale);
+}
+
+double RefinementPolicy::sizeOf(std::size_t polygon, const std::vector<Point4> &vertices) const {
+  double polygonSize = size;
+  if (polygon < polygonSizes.size() && polygonSizes[polygon] > 0.0) polygonSize = polygonSizes[polygon];
+  if (!adaptive || vertices.empty()) return polygonSize;
+  
+  // A polygon is refined uniformly, so it takes the smallest scale found at
+  // its vertices and its centroid
+  double centroid[4] = {0.0, 0.0, 0.0, 0.0};
+  double scale = maximumScale;
+  for (auto const &vertex : vertices) {
+    scale = std::min(scale, scaleAt(vertex));
+    for (unsigned int coordinate = 0; coordinate < 4; ++coordinate) centroid[coordinate] += vertex[coordinate]/vertices.size();
+  } scale = std::min(scale, scaleAt(Point4(centroid)));
+  return polygonSize*scale;
+}
+
+double RefinementPolicy::edgeLengthAt(const Point4 &point) const {
+  return edgeLength*scaleAt(point);
+}
@@ -0,0 +1,54 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RefinementPolicy_hpp
+#define RefinementPolicy_hpp
+
+#include <cstddef>
+#include <vector>
+
+#include "Geometry4.hpp"
+
+// How finely faces are refined and edges are split before they are
+// projected. Sizes are upper bounds on the length of triangle and edge
+// segment sides, in model units.
+struct RefinementPolicy {
+  double ratio = 0.125;
+  double size = 0.1;
+  double edgeLength = 0.1;
+  
+  // Per-polygon size, indexed like Model_d::polygons. A missing or
+  // non-positive entry means that size is used.
+  std::vector<double> polygonSizes;
+  
+  // In adaptive mode, sizes are multiplied by the inverse of the local scale
+  // of the stereographic projection from pole, |p|(1-w) for a point p that
+  // lands at height w on the unit 3-sphere, so that faces and edges are dense
+  // only where the projection magnifies them. The factor is clamped to
+  // [minimumScale, maximumScale].
+  bool adaptive = false;
+  Point4 pole = Point4(0.0, 0.0, 0.0, 1.0);
+  double minimumScale = 0.25;
+  double maximumScale = 2.0;
+  
+  // All sizes and scales must be positive
+  double scaleAt(const Point4 &point) const;
+  double sizeOf(std::size_t polygon, const std::vector<Point4> &vertices) const;
+  double edgeLengthAt(const Point4 &point) const;
+};
+
+#endif /* RefinementPolicy_hpp */
@@ -0,0 +1,74 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Rotation4.hpp"
+
+#include <cmath>
+#include <utility>
+
+static Quaternion basisQuaternion(unsigned int axis) {
+  Quaternion quaternion{0.0, 0.0, 0.0, 0.0};
+  switch (axis) {
+    case 0: quaternion.a = 1.0; break;
+    case 1: quaternion.b = 1.0; break;
+    case 2: quaternion.c = 1.0; break;
+    default: quaternion.d = 1.0; break;
+  } return quaternion;
+}
+
+static void normalise(Quaternion &quaternion) {
+  double norm = std::sqrt(quaternion.a*quaternion.a+quaternion.b*quaternion.b+quaternion.c*quaternion.c+quaternion.d*quaternion.d);
+  quaternion.a /= norm;
+  quaternion.b /= norm;
+  quaternion.c /= norm;
+  quaternion.d /= norm;
+}
+
+void Rotation4::rotate(unsigned int first, unsigned int second, double angle) {
+  
+  // A plane through the real axis 1 and an imaginary axis u is turned by
+  // u*(angle/2) on both sides. Any other plane spans two imaginary axes e1
+  // and e2 and is turned by u*(angle/2) on the left and -u*(angle/2) on the
+  // right, where u = e1*e2 is the imaginary axis perpendicular to both.
+  if (first == second) return;
+  double sign = 1.0;
+  if (second == 0) {
+    std::swap(first, second);
+    sign = -1.0;
+  } double s = std::sin(sign*angle/2.0), c = std::cos(sign*angle/2.0);
+  Quaternion u = (first == 0) ? basisQuaternion(second) : basisQuaternion(first)*basisQuaternion(second);
+  Quaternion rotationLeft{c, s*u.b, s*u.c, s*u.d};
+  Quaternion rotationRight = (first == 0) ? rotationLeft : Quaternion{c, -s*u.b, -s*u.c, -s*u.d};
+  
+  left = rotationLeft*left;
+  right = right*rotationRight;
+  normalise(left);
+  normalise(right);
+}
+
+void Rotation4::reset() {
+  left = Quaternion{1.0, 0.0, 0.0, 0.0};
+  right = Quaternion{1.0, 0.0, 0.0, 0.0};
+}
+
+Matrix4 Rotation4::matrix() const {
+  Matrix4 matrix;
+  for (unsigned int axis = 0; axis < 4; ++axis) {
+    Quaternion image = left*basisQuaternion(axis)*right;
+    matrix.columns[axis] = Float4(image.a, image.b, image.c, image.d);
+  } return matrix;
+}
@@ -0,0 +1,53 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef Rotation4_hpp
+#define Rotation4_hpp
+
+#include "Projection.hpp"
+
+// Quaternion a+b*i+c*j+d*k, which also stands for the 4D point (a, b, c, d)
+struct Quaternion {
+  double a, b, c, d;
+  
+  Quaternion operator*(const Quaternion &q) const {
+    return Quaternion{a*q.a-b*q.b-c*q.c-d*q.d,
+                      a*q.b+b*q.a+c*q.d-d*q.c,
+                      a*q.c-b*q.d+c*q.a+d*q.b,
+                      a*q.d+b*q.c-c*q.b+d*q.a};
+  }
+};
+
+// Accumulated 4D rotation, kept as a pair of unit quaternions so that a point
+// p goes to left*p*right. Unlike a product of matrices, the pair is
+// renormalised after every update and so cannot drift away from a rotation
+// however long the user keeps dragging.
+class Rotation4 {
+public:
+  // Rotates by angle radians in the plane of axes first and second, turning
+  // the first towards the second, after everything accumulated so far
+  void rotate(unsigned int first, unsigned int second, double angle);
+  void reset();
+  // The whole rotation as a single matrix, to compose with the projection
+  Matrix4 matrix() const;
+  
+private:
+  Quaternion left = Quaternion{1.0, 0.0, 0.0, 0.0};
+  Quaternion right = Quaternion{1.0, 0.0, 0.0, 0.0};
+};
+
+#endif /* Rotation4_hpp */
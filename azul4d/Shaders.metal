@@ -23,6 +23,8 @@ struct RenderingConstants {
 
 struct ProjectionParameters {
   float4x4 transformationMatrix;
+  float4x4 viewBasis;  // Orthographic camera axes, computed on the host
+  float4 viewFrom;     // Orthographic camera position
 };
 
 struct VertexIn {
@@ -38,8 +40,12 @@ struct VertexOut {
 kernel void stereographicProjection(const device VertexIn *verticesIn [[buffer(0)]],
                                     device VertexIn *verticesOut [[buffer(1)]],
                                     constant ProjectionParameters &projectionParameters [[buffer(2)]],
+                                    constant uint &count [[buffer(3)]],
                                     uint id [[thread_position_in_grid]]) {
   
+  // The last thread group can reach past the end
+  if (id >= count) return;
+  
   // Apply 4D transformation
   float4 transformedVertex = projectionParameters.transformationMatrix * verticesIn[id].position;
 
@@ -109,6 +115,29 @@ kernel void stereographicProjection(const device VertexIn *verticesIn [[buffer(0
   verticesOut[id].colour = verticesIn[id].colour;
 }
 
+// Same projection as stereographicProjection without the detour through
+// hyperspherical angles: going to angles and back only normalises the point
+// to the unit 3-sphere, so normalise directly and divide by w-1
+kernel void fastStereographicProjection(const device VertexIn *verticesIn [[buffer(0)]],
+                                        device VertexIn *verticesOut [[buffer(1)]],
+                                        constant ProjectionParameters &projectionParameters [[buffer(2)]],
+                                        constant uint &count [[buffer(3)]],
+                                        uint id [[thread_position_in_grid]]) {
+  
+  if (id >= count) return;
+  
+  // Apply 4D transformation
+  float4 transformedVertex = projectionParameters.transformationMatrix * verticesIn[id].position;
+  
+  // Project from R4 to S3, where the origin goes to (1, 0, 0, 0) like in stereographicProjection
+  float r = length(transformedVertex);
+  float4 point_r4 = (r != 0) ? transformedVertex/r : float4(1.0, 0.0, 0.0, 0.0);
+  
+  // Project from R4 to R3 and output
+  verticesOut[id].position = float4(point_r4.xyz/(point_r4.w-1), 1.0);
+  verticesOut[id].colour = verticesIn[id].colour;
+}
+
 vertex VertexOut vertexLit(device VertexIn *vertices [[buffer(0)]],
                            constant RenderingConstants &uniforms [[buffer(1)]],
                            uint VertexId [[vertex_id]]) {
@@ -118,47 +147,32 @@ vertex VertexOut vertexLit(device VertexIn *vertices [[buffer(0)]],
   return out;
 }
 
-float4 normalise4(float4 v) {
-  float norm = v.x*v.x+v.y*v.y+v.z*v.z+v.w*v.w;
-  float4 vnormalised = float4(v.x/norm, v.y/norm, v.z/norm, v.w/norm);
-  return vnormalised;
-}
-
-float determinant2(float a, float b, float c, float d) {
-  return a*d - b*c;
-}
-
-float determinant3(float a, float b, float c, float d, float e, float f, float g, float h, float i) {
-  return a*determinant2(e, f, h, i) - b*determinant2(d, f, g, i) + c*determinant2(d, e, g, h);
-}
-
-float4 crossProduct4(float4 u, float4 v, float4 w) {
-  return float4(determinant3(u.y, u.z, u.w, v.y, v.z, v.w, w.y, w.z, w.w),
-                -determinant3(u.x, u.z, u.w, v.x, v.z, v.w, w.x, w.z, w.w),
-                determinant3(u.x, u.y, u.w, v.x, v.y, v.w, w.x, w.y, w.w),
-                -determinant3(u.x, u.y, u.z, v.x, v.y, v.z, w.x, w.y, w.z));
+// Vertex marker: one instance of the unit sphere per projected vertex
+vertex VertexOut vertexSphere(const device float4 *sphere [[buffer(0)]],
+                              const device VertexIn *centres [[buffer(1)]],
+                              constant RenderingConstants &uniforms [[buffer(2)]],
+                              constant float &radius [[buffer(3)]],
+                              uint VertexId [[vertex_id]],
+                              uint InstanceId [[instance_id]]) {
+  VertexOut out;
+  float4 position = centres[InstanceId].position+radius*float4(sphere[VertexId].xyz, 0.0);
+  out.position = uniforms.modelViewProjectionMatrix * position;
+  out.colour = centres[InstanceId].colour;
+  return out;
 }
 
 kernel void orthographicProjection(const device VertexIn *verticesIn [[buffer(0)]],
                                    device VertexIn *verticesOut [[buffer(1)]],
                                    constant ProjectionParameters &projectionParameters [[buffer(2)]],
+                                   constant uint &count [[buffer(3)]],
                                    uint id [[thread_position_in_grid]]) {
   
+  if (id >= count) return;
+  
   // Apply 4D transformation
   float4 transformedVertex = projectionParameters.transformationMatrix * verticesIn[id].position;
   
-  float4 from = float4(0.0, 1.0, 0.0, 0.0);
-  float4 to = float4(0.0, 0.0, 0.0, 0.0);
-  float4 up = float4(0.0, 0.0, 1.0, 0.0);
-  float4 over = float4(0.0, 0.0, 0.0, 1.0);
-  
-  float4 d = normalise4(float4(to.x-from.x, to.y-from.y, to.z-from.z, to.w-from.w));  // Along y
-  float4 a = normalise4(crossProduct4(up, over, d));  // Along x
-  float4 b = normalise4(crossProduct4(over, d, a));   // Along z
-  float4 c = crossProduct4(d, a, b)*2.0;  // Along w
-  
-  float4x4 m(a, b, c, d);
-  float4 eye = (transformedVertex-from) * m;
+  float4 eye = (transformedVertex-projectionParameters.viewFrom) * projectionParameters.viewBasis;
   
   // Output
   verticesOut[id].position = float4(eye.x, eye.y, eye.z, 1.0);
@@ -168,8 +182,11 @@ kernel void orthographicProjection(const device VertexIn *verticesIn [[buffer(0)
 kernel void longAxisProjection(const device VertexIn *verticesIn [[buffer(0)]],
                                    device VertexIn *verticesOut [[buffer(1)]],
                                    constant ProjectionParameters &projectionParameters [[buffer(2)]],
+                                   constant uint &count [[buffer(3)]],
                                    uint id [[thread_position_in_grid]]) {
   
+  if (id >= count) return;
+  
   // Apply 4D transformation
   float4 transformedVertex = projectionParameters.transformationMatrix * verticesIn[id].position;
   float3 longAxis = float3(2.0*transformedVertex.w, 0.0*transformedVertex.w, 0.0*transformedVertex.w);
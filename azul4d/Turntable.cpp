@@ -0,0 +1,58 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Turntable.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#include "Parallel.hpp"
+
+bool Turntable::setPlane(const std::string &plane) {
+  const char *axes = "xyzw";
+  if (plane.size() != 2 || plane[0] == plane[1] || strchr(axes, plane[0]) == nullptr || strchr(axes, plane[1]) == nullptr) return false;
+  first = (unsigned int)(strchr(axes, plane[0])-axes);
+  second = (unsigned int)(strchr(axes, plane[1])-axes);
+  return true;
+}
+
+ProjectionParameters Turntable::frameParameters(std::size_t frame, const ProjectionParameters &projectionParameters) const {
+  Rotation4 frameRotation = rotation;
+  frameRotation.rotate(first, second, double(frame)*step);
+  ProjectionParameters parameters = projectionParameters;
+  parameters.transformationMatrix = frameRotation.matrix();
+  return parameters;
+}
+
+std::string framePath(const std::string &pathPattern, std::size_t frame) {
+  std::size_t last = pathPattern.rfind('#');
+  if (last == std::string::npos) return pathPattern;
+  std::size_t first = pathPattern.find_last_not_of('#', last);
+  first = (first == std::string::npos) ? 0 : first+1;
+  std::string number = std::to_string(frame);
+  if (number.size() < last+1-first) number.insert(0, last+1-first-number.size(), '0');
+  return pathPattern.substr(0, first)+number+pathPattern.substr(last+1);
+}
+
+bool exportTurntable(const std::string &pathPattern, ExportFormat format, const GeometryView &geometry, const Float4 &edgeColour,
+                     Projection projection, const ProjectionParameters &projectionParameters, const Turntable &turntable) {
+  std::atomic<bool> exported(true);
+  parallelFor(turntable.frames, [&](std::size_t frame) {
+    if (!exportProjected(framePath(pathPattern, frame), format, geometry, edgeColour, projection, turntable.frameParameters(frame, projectionParameters))) exported = false;
+  });
+  return exported;
+}
@@ -0,0 +1,53 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef Turntable_hpp
+#define Turntable_hpp
+
+#include <cstddef>
+#include <string>
+
+#include "Export.hpp"
+#include "Rotation4.hpp"
+
+// A sequence of frames that turn a model in one plane, like dragging it in
+// the app: frame i is rotated by rotation and then by i*step radians in the
+// plane of axes first and second, turning the first towards the second
+struct Turntable {
+  Rotation4 rotation;
+  unsigned int first = 0;
+  unsigned int second = 1;
+  double step = 0.0;
+  std::size_t frames = 1;
+  
+  // Parses a plane such as "xy" or "wx"
+  bool setPlane(const std::string &plane);
+  ProjectionParameters frameParameters(std::size_t frame, const ProjectionParameters &projectionParameters) const;
+};
+
+// Path of a frame: the last run of # in pathPattern replaced by the frame
+// number, padded with zeros to the length of the run
+std::string framePath(const std::string &pathPattern, std::size_t frame);
+
+// Exports every frame of turntable with exportProjected() to its own
+// framePath(pathPattern, frame). Frames are projected and written in
+// parallel, each with its own buffers, while geometry is shared by all.
+// Returns false if any frame could not be written.
+bool exportTurntable(const std::string &pathPattern, ExportFormat format, const GeometryView &geometry, const Float4 &edgeColour,
+                     Projection projection, const ProjectionParameters &projectionParameters, const Turntable &turntable);
+
+#endif /* Turntable_hpp */
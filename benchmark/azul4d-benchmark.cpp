@@ -0,0 +1,278 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Benchmarks the geometry hot paths on the built-in models and on synthetic
+// scaled-up ones, and prints the results as JSON.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sys/resource.h>
+
+#include "CppLink.hpp"
+#include "Polytopes.hpp"
+#include "Projection.hpp"
+
+// Count every heap allocation made by the process
+static std::atomic<std::size_t> allocations(0);
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (void *pointer = std::malloc(size ? size : 1)) return pointer;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+static std::size_t peakResidentSetSize() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  return usage.ru_maxrss*1024;
+#endif
+}
+
+struct BenchmarkResult {
+  std::string benchmark;
+  std::string model;
+  std::size_t polygons;
+  std::size_t triangles;
+  std::size_t repetitions;
+  double seconds;
+  std::size_t allocations;
+};
+
+// Runs function repetitions times. function returns the number of triangles it produced.
+template <class Function>
+BenchmarkResult measure(const std::string &benchmark, const std::string &modelName, std::size_t polygons, std::size_t repetitions, Function function) {
+  BenchmarkResult result;
+  result.benchmark = benchmark;
+  result.model = modelName;
+  result.polygons = polygons;
+  result.repetitions = repetitions;
+  result.triangles = 0;
+  std::size_t allocationsBefore = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t repetition = 0; repetition < repetitions; ++repetition) result.triangles = function();
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()/repetitions;
+  result.allocations = (allocations-allocationsBefore)/repetitions;
+  return result;
+}
+
+// A single regular polygon with many vertices on a plane that is not aligned with the axes
+static Model_d generateManySidedPolygon(unsigned int sides) {
+  Model_d model;
+  model.materials.push_back(Float4(0.0, 0.0, 1.0, 0.2));
+  Vector4 u(0.5, 0.5, 0.5, 0.5);
+  Vector4 v(0.5, -0.5, 0.5, -0.5);
+  Point4 centre(0.0, 0.0, 0.0, 0.0);
+  model.polygons.push_back(Polygon_d());
+  for (unsigned int side = 0; side < sides; ++side) {
+    double angle = 2.0*3.141592653589793*side/sides;
+    model.polygons.back().vertices.push_back(centre+std::cos(angle)*u+std::sin(angle)*v);
+  } model.materialOfFace.push_back(0);
+  return model;
+}
+
+// fastStereographicProjection must match stereographicProjection to within
+// this relative error
+static const double stereographicTolerance = 1e-3;
+
+// A rotation in the xw plane followed by one in the yz plane, so that points
+// are projected from positions that are not aligned with the axes
+static ProjectionParameters rotatedProjectionParameters() {
+  ProjectionParameters projectionParameters;
+  float c = std::cos(0.3f), s = std::sin(0.3f);
+  Matrix4 &matrix = projectionParameters.transformationMatrix;
+  matrix.columns[0] = Float4(c, 0.0f, 0.0f, s);
+  matrix.columns[1] = Float4(0.0f, c, s, 0.0f);
+  matrix.columns[2] = Float4(0.0f, -s, c, 0.0f);
+  matrix.columns[3] = Float4(-s, 0.0f, 0.0f, c);
+  return projectionParameters;
+}
+
+// Largest difference between the two stereographic projections, relative to
+// the magnitude of the reference coordinate but at least 1
+static double stereographicError(const std::vector<Vertex4> &vertices, const ProjectionParameters &projectionParameters) {
+  std::vector<Vertex4> reference(vertices.size()), fast(vertices.size());
+  stereographicProjection(vertices.data(), reference.data(), vertices.size(), projectionParameters);
+  fastStereographicProjection(vertices.data(), fast.data(), vertices.size(), projectionParameters);
+  double maximumError = 0.0;
+  for (std::size_t vertex = 0; vertex < vertices.size(); ++vertex) {
+    for (unsigned int coordinate = 0; coordinate < 3; ++coordinate) {
+      double expected = reference[vertex].position[coordinate], actual = fast[vertex].position[coordinate];
+      if (std::isinf(expected) && expected == actual) continue;
+      double error = std::abs(actual-expected)/std::max(1.0, std::abs(expected));
+      if (!(error <= maximumError)) maximumError = error;
+    }
+  } return maximumError;
+}
+
+static std::size_t countTriangles(const std::vector<Mesh_d> &meshes) {
+  std::size_t triangles = 0;
+  for (auto const &mesh : meshes) triangles += mesh.numberOfTriangles();
+  return triangles;
+}
+
+static void benchmarkModel(CppLink &cppLink, const std::string &modelName, Model_d &model, std::size_t repetitions, std::vector<BenchmarkResult> &results, double &maximumStereographicError) {
+  std::vector<Polygon_d> &polygons = model.polygons;
+  const RefinementPolicy &policy = model.refinementPolicy;
+  
+  // Measure the refinement itself except in load_cached
+  cppLink.useRefinementCache = false;
+  results.push_back(measure("refine", modelName, polygons.size(), repetitions, [&]() {
+    std::size_t triangles = 0;
+    for (auto &polygon : polygons) triangles += cppLink.refine(polygon, policy.ratio, policy.size).numberOfTriangles();
+    return triangles;
+  }));
+  results.push_back(measure("refine_parallel", modelName, polygons.size(), repetitions, [&]() {
+    return countTriangles(cppLink.refine(polygons, policy));
+  }));
+  results.push_back(measure("generateEdges", modelName, polygons.size(), repetitions, [&]() {
+    cppLink.generateEdges(polygons, policy);
+    return std::size_t(0);
+  }));
+  results.push_back(measure("generateVertices", modelName, polygons.size(), repetitions, [&]() {
+    cppLink.generateVertices(polygons);
+    return std::size_t(0);
+  }));
+  results.push_back(measure("triangulateUsingBarycentre", modelName, polygons.size(), repetitions, [&]() {
+    std::size_t triangles = 0;
+    for (auto &polygon : polygons) triangles += cppLink.triangulateUsingBarycentre(polygon).numberOfTriangles();
+    return triangles;
+  }));
+  
+  bool allQuads = true;
+  for (auto const &polygon : polygons) if (polygon.vertices.size() != 4) allQuads = false;
+  if (allQuads) results.push_back(measure("triangulateQuad", modelName, polygons.size(), repetitions, [&]() {
+    std::size_t triangles = 0;
+    for (auto &polygon : polygons) triangles += cppLink.triangulateQuad(polygon).numberOfTriangles();
+    return triangles;
+  }));
+  
+  results.push_back(measure("load", modelName, polygons.size(), repetitions, [&]() {
+    cppLink.load(model);
+    return cppLink.geometryView.numberOfTriangles();
+  }));
+  
+  std::vector<Vertex4> faceVertices(cppLink.numberOfFaceVertices()), projectedVertices(faceVertices.size());
+  cppLink.copyFaceVertices(faceVertices.data());
+  ProjectionParameters projectionParameters = rotatedProjectionParameters();
+  results.push_back(measure("stereographicProjection", modelName, polygons.size(), repetitions, [&]() {
+    stereographicProjection(faceVertices.data(), projectedVertices.data(), faceVertices.size(), projectionParameters);
+    return faceVertices.size()/3;
+  }));
+  results.push_back(measure("fastStereographicProjection", modelName, polygons.size(), repetitions, [&]() {
+    fastStereographicProjection(faceVertices.data(), projectedVertices.data(), faceVertices.size(), projectionParameters);
+    return faceVertices.size()/3;
+  }));
+  maximumStereographicError = std::max(maximumStereographicError, stereographicError(faceVertices, ProjectionParameters()));
+  maximumStereographicError = std::max(maximumStereographicError, stereographicError(faceVertices, projectionParameters));
+  
+  cppLink.useRefinementCache = true;
+  cppLink.refinementCache.clear();
+  cppLink.load(model);
+  results.push_back(measure("load_cached", modelName, polygons.size(), repetitions, [&]() {
+    cppLink.load(model);
+    return cppLink.geometryView.numberOfTriangles();
+  }));
+}
+
+static void writeJson(std::ostream &stream, const std::vector<BenchmarkResult> &results, double maximumStereographicError) {
+  stream << "{\n  \"peak_rss_bytes\": " << peakResidentSetSize() << ",\n  \"threads\": " << numberOfWorkerThreads()
+  << ",\n  \"fast_stereographic_max_error\": " << maximumStereographicError << ",\n  \"results\": [\n";
+  for (std::size_t index = 0; index < results.size(); ++index) {
+    const BenchmarkResult &result = results[index];
+    stream << "    {\"benchmark\": \"" << result.benchmark << "\", \"model\": \"" << result.model << "\""
+    << ", \"polygons\": " << result.polygons << ", \"triangles\": " << result.triangles
+    << ", \"repetitions\": " << result.repetitions << ", \"seconds\": " << result.seconds
+    << ", \"polygons_per_second\": " << result.polygons/result.seconds
+    << ", \"triangles_per_second\": " << result.triangles/result.seconds
+    << ", \"allocations\": " << result.allocations << "}" << (index+1 < results.size() ? ",\n" : "\n");
+  } stream << "  ]\n}" << std::endl;
+}
+
+static void printUsage() {
+  std::cerr << "Usage: azul4d-benchmark [--grid n] [--sides n] [--repetitions n] [--json output.json]" << std::endl;
+}
+
+int main(int argc, const char *argv[]) {
+  unsigned int gridSize = 3;
+  unsigned int sides = 1000;
+  std::size_t repetitions = 3;
+  std::string jsonPath;
+  for (int argument = 1; argument < argc; ++argument) {
+    if (argument+1 >= argc) {
+      printUsage();
+      return 1;
+    } if (strcmp(argv[argument], "--grid") == 0) gridSize = atoi(argv[++argument]);
+    else if (strcmp(argv[argument], "--sides") == 0) sides = atoi(argv[++argument]);
+    else if (strcmp(argv[argument], "--repetitions") == 0) repetitions = atoi(argv[++argument]);
+    else if (strcmp(argv[argument], "--json") == 0) jsonPath = argv[++argument];
+    else {
+      printUsage();
+      return 1;
+    }
+  } if (gridSize < 1 || gridSize > maximumGridSize || sides < 3 || repetitions < 1) {
+    printUsage();
+    return 1;
+  }
+  
+  CppLink cppLink;
+  std::vector<BenchmarkResult> results;
+  double maximumStereographicError = 0.0;
+  
+  Model_d tesseract = cppLink.generateTesseract();
+  benchmarkModel(cppLink, "tesseract", tesseract, repetitions, results, maximumStereographicError);
+  Model_d house = cppLink.generateHouse();
+  benchmarkModel(cppLink, "house", house, repetitions, results, maximumStereographicError);
+  Model_d corridor = cppLink.generateCorridor();
+  benchmarkModel(cppLink, "corridor", corridor, repetitions, results, maximumStereographicError);
+  Model_d grid = generateTesseractGrid(gridSize);
+  benchmarkModel(cppLink, "tesseract_grid_" + std::to_string(gridSize), grid, repetitions, results, maximumStereographicError);
+  Model_d polygon = generateManySidedPolygon(sides);
+  benchmarkModel(cppLink, "polygon_" + std::to_string(sides), polygon, repetitions, results, maximumStereographicError);
+  
+  if (jsonPath.empty()) writeJson(std::cout, results, maximumStereographicError);
+  else {
+    std::ofstream file(jsonPath);
+    writeJson(file, results, maximumStereographicError);
+    if (!file) {
+      std::cerr << "Could not write " << jsonPath << std::endl;
+      return 1;
+    }
+  }
+  
+  if (maximumStereographicError > stereographicTolerance) {
+    std::cerr << "fastStereographicProjection differs from stereographicProjection by " << maximumStereographicError << std::endl;
+    return 1;
+  }
+  
+  return 0;
+}
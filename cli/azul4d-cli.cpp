@@ -0,0 +1,244 @@
+// azul4d
+// Copyright © 2016 Ken Arroyo Ohori
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "CppLink.hpp"
+#include "Export.hpp"
+#include "ModelReader.hpp"
+#include "Polytopes.hpp"
+#include "Projection.hpp"
+#include "Rotation4.hpp"
+#include "Turntable.hpp"
+
+// Most frames --turntable writes, each one a file
+static const unsigned long maximumTurntableFrames = 100000;
+
+// Reads a decimal count of at most maximum at text, without a sign, and
+// moves text past it
+static bool parseCount(const char *&text, unsigned long maximum, unsigned int &count) {
+  if (*text < '0' || *text > '9') return false;
+  char *end;
+  errno = 0;
+  unsigned long value = std::strtoul(text, &end, 10);
+  if (errno != 0 || value > maximum) return false;
+  count = (unsigned int)value;
+  text = end;
+  return true;
+}
+
+// Reads a whole argument as a finite number greater than 0
+static bool parseSize(const char *text, double &size) {
+  char *end;
+  double value = std::strtod(text, &end);
+  if (end == text || *end != '\0' || !std::isfinite(value) || value <= 0.0) return false;
+  size = value;
+  return true;
+}
+
+// grid:n with 1 <= n <= maximumGridSize or duoprism:p,q with
+// 3 <= p, q <= maximumDuoprismSides, and nothing after them
+static bool parseGrid(const std::string &modelName, unsigned int &n) {
+  if (modelName.compare(0, 5, "grid:") != 0) return false;
+  const char *text = modelName.c_str()+5;
+  return parseCount(text, maximumGridSize, n) && n >= 1 && *text == '\0';
+}
+
+static bool parseDuoprism(const std::string &modelName, unsigned int &p, unsigned int &q) {
+  if (modelName.compare(0, 9, "duoprism:") != 0) return false;
+  const char *text = modelName.c_str()+9;
+  if (!parseCount(text, maximumDuoprismSides, p) || *text++ != ',') return false;
+  return parseCount(text, maximumDuoprismSides, q) && p >= 3 && q >= 3 && *text == '\0';
+}
+
+static void printUsage() {
+  std::cerr << "Usage: azul4d-cli <tesseract|house|corridor|24-cell|120-cell|600-cell|grid:n|duoprism:p,q|model.off4|model.a4dg> [--obj output.obj] [--export output.obj|ply|glb] [--off4 output.off4] [--a4dg output.a4dg] [--cache directory] [--size s] [--edge-length l] [--adaptive] [--projection stereographic|fast-stereographic|orthographic|long-axis] [--from x,y,z,w] [--rotate plane:angle]... [--turntable plane:step:frames --export frame####.ply] (frames up to 100000)" << std::endl;
+}
+
+int main(int argc, const char *argv[]) {
+  if (argc < 2) {
+    printUsage();
+    return 1;
+  }
+  
+  std::string modelName = argv[1];
+  std::string objPath;
+  std::string off4Path;
+  std::string exportPath;
+  std::string a4dgPath;
+  std::string cacheDirectory;
+  RefinementPolicy refinementPolicy;
+  Projection projection = Projection::stereographic;
+  ProjectionParameters projectionParameters;
+  Rotation4 rotation;
+  Turntable turntable;
+  bool animate = false;
+  for (int argument = 2; argument < argc; ++argument) {
+    if (strcmp(argv[argument], "--obj") == 0 && argument+1 < argc) objPath = argv[++argument];
+    else if (strcmp(argv[argument], "--export") == 0 && argument+1 < argc) exportPath = argv[++argument];
+    else if (strcmp(argv[argument], "--off4") == 0 && argument+1 < argc) off4Path = argv[++argument];
+    else if (strcmp(argv[argument], "--a4dg") == 0 && argument+1 < argc) a4dgPath = argv[++argument];
+    else if (strcmp(argv[argument], "--cache") == 0 && argument+1 < argc) cacheDirectory = argv[++argument];
+    else if (strcmp(argv[argument], "--size") == 0 && argument+1 < argc) {
+      if (!parseSize(argv[++argument], refinementPolicy.size)) {
+        printUsage();
+        return 1;
+      }
+    } else if (strcmp(argv[argument], "--edge-length") == 0 && argument+1 < argc) {
+      if (!parseSize(argv[++argument], refinementPolicy.edgeLength)) {
+        printUsage();
+        return 1;
+      }
+    }
+    else if (strcmp(argv[argument], "--adaptive") == 0) refinementPolicy.adaptive = true;
+    else if (strcmp(argv[argument], "--from") == 0 && argument+1 < argc) {
+      float from[4];
+      if (sscanf(argv[++argument], "%f,%f,%f,%f", &from[0], &from[1], &from[2], &from[3]) != 4) {
+        printUsage();
+        return 1;
+      } projectionParameters.setViewpoint(Float4(from[0], from[1], from[2], from[3]), Float4(0.0f, 0.0f, 0.0f, 0.0f), Float4(0.0f, 0.0f, 1.0f, 0.0f), Float4(0.0f, 0.0f, 0.0f, 1.0f));
+    } else if (strcmp(argv[argument], "--rotate") == 0 && argument+1 < argc) {
+      const char *axes = "xyzw";
+      char plane[3];
+      double angle;
+      if (sscanf(argv[++argument], "%2[xyzw]:%lf", plane, &angle) != 2 || strlen(plane) != 2 || plane[0] == plane[1]) {
+        printUsage();
+        return 1;
+      } rotation.rotate(strchr(axes, plane[0])-axes, strchr(axes, plane[1])-axes, angle);
+    } else if (strcmp(argv[argument], "--turntable") == 0 && argument+1 < argc) {
+      char plane[3];
+      unsigned int frames = 0;
+      int framesStart = 0;
+      const char *text = argv[++argument];
+      if (sscanf(text, "%2[xyzw]:%lf:%n", plane, &turntable.step, &framesStart) != 2 || framesStart == 0 || !turntable.setPlane(plane) || !std::isfinite(turntable.step) ||
+          !parseCount(text += framesStart, maximumTurntableFrames, frames) || frames == 0 || *text != '\0') {
+        printUsage();
+        return 1;
+      } turntable.frames = frames;
+      animate = true;
+    } else if (strcmp(argv[argument], "--projection") == 0 && argument+1 < argc) {
+      if (!projectionFromName(argv[++argument], projection)) {
+        printUsage();
+        return 1;
+      }
+    }
+    else {
+      printUsage();
+      return 1;
+    }
+  }
+  
+  if (animate && exportPath.find('#') == std::string::npos) {
+    printUsage();
+    return 1;
+  }
+  
+  projectionParameters.transformationMatrix = rotation.matrix();
+  turntable.rotation = rotation;
+  
+  CppLink cppLink;
+  cppLink.refinementCache.directory = cacheDirectory;
+  cppLink.useRefinementCache = !cacheDirectory.empty();
+  Model_d model;
+  std::vector<StageTiming> timings;
+  
+  // Generate or open, then refine, edges and vertices
+  auto start = std::chrono::steady_clock::now();
+  unsigned int p = 0, q = 0;
+  bool grid = parseGrid(modelName, p), duoprism = !grid && parseDuoprism(modelName, p, q);
+  if (modelName.compare(0, 5, "grid:") == 0 && !grid) {
+    std::cerr << modelName << ": expected a grid size from 1 to " << maximumGridSize << std::endl;
+    return 1;
+  } if (modelName.compare(0, 9, "duoprism:") == 0 && !duoprism) {
+    std::cerr << modelName << ": expected two numbers of sides from 3 to " << maximumDuoprismSides << std::endl;
+    return 1;
+  } if (modelName == "tesseract" || modelName == "house" || modelName == "corridor" || modelName == "24-cell" || modelName == "120-cell" || modelName == "600-cell" || grid || duoprism) {
+    if (modelName == "tesseract") model = cppLink.generateTesseract();
+    else if (modelName == "house") model = cppLink.generateHouse();
+    else if (modelName == "corridor") model = cppLink.generateCorridor();
+    else if (modelName == "24-cell") model = generate24Cell();
+    else if (modelName == "120-cell") model = generate120Cell();
+    else if (modelName == "600-cell") model = generate600Cell();
+    else if (grid) model = generateTesseractGrid(p);
+    else model = generateDuoprism(p, q);
+    model.refinementPolicy = refinementPolicy;
+    timings.push_back(StageTiming{"generate", std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()});
+    cppLink.load(model);
+  } else if (modelName.size() > 5 && modelName.compare(modelName.size()-5, 5, ".a4dg") == 0) {
+    std::string error;
+    if (!cppLink.makeFromGeometryFile(modelName, error)) {
+      std::cerr << modelName << ": " << error << std::endl;
+      return 1;
+    } timings.push_back(StageTiming{"map", std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()});
+  } else {
+    ModelReader reader;
+    model.refinementPolicy = refinementPolicy;
+    bool opened = reader.open(modelName);
+    timings.push_back(StageTiming{"open", std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()});
+    if (!opened || !cppLink.load(reader, model)) {
+      std::cerr << modelName << ": " << reader.error << std::endl;
+      return 1;
+    }
+  } timings.insert(timings.end(), cppLink.timings.begin(), cppLink.timings.end());
+  cppLink.timings.clear();
+  
+  // Export. --obj is the same as --export with an .obj path.
+  bool exported = true;
+  if (!objPath.empty()) cppLink.timeStage("export", [&]() {
+    exported = exportProjected(objPath, ExportFormat::obj, cppLink.geometryView, cppLink.edgeColour, projection, projectionParameters);
+  });
+  if (!exported) {
+    std::cerr << "Could not write " << objPath << std::endl;
+    return 1;
+  } if (!exportPath.empty()) cppLink.timeStage(animate ? "export turntable" : "export projected", [&]() {
+    ExportFormat format;
+    if (!exportFormatFromPath(exportPath, format)) exported = false;
+    else if (animate) exported = exportTurntable(exportPath, format, cppLink.geometryView, cppLink.edgeColour, projection, projectionParameters, turntable);
+    else exported = exportProjected(exportPath, format, cppLink.geometryView, cppLink.edgeColour, projection, projectionParameters);
+  });
+  if (!exported) {
+    std::cerr << "Could not write " << exportPath << std::endl;
+    return 1;
+  } if (!off4Path.empty()) cppLink.timeStage("export 4OFF", [&]() {
+    exported = writeOff4(off4Path, model);
+  });
+  if (!exported) {
+    std::cerr << "Could not write " << off4Path << std::endl;
+    return 1;
+  } if (!a4dgPath.empty()) cppLink.timeStage("export geometry", [&]() {
+    exported = cppLink.writeGeometryFile(a4dgPath);
+  });
+  timings.insert(timings.end(), cppLink.timings.begin(), cppLink.timings.end());
+  if (!exported) {
+    std::cerr << "Could not write " << a4dgPath << std::endl;
+    return 1;
+  }
+  
+  std::cout << modelName << ": " << cppLink.geometryView.numberOfFaces() << " polygons, " << cppLink.geometryView.numberOfTriangles() << " triangles, " << cppLink.numberOfEdges() << " edges, " << cppLink.numberOfVertices() << " vertices, " << cppLink.numberOfPositions() << " welded positions" << std::endl;
+  std::cout << "  refinement cache: " << cppLink.refinementCache.hits() << " hits, " << cppLink.refinementCache.misses() << " misses" << std::endl;
+  double total = 0.0;
+  for (auto const &timing : timings) {
+    std::cout << "  " << timing.stage << ": " << timing.seconds*1000.0 << " ms" << std::endl;
+    total += timing.seconds;
+  } std::cout << "  total: " << total*1000.0 << " ms" << std::endl;
+  
+  return 0;
+}